@@ -8,7 +8,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 #include <bgl/bgl.h>
 
@@ -106,29 +105,23 @@ int main() {
     }
 
     int fps_lim = 60;
-    int64_t delay = (int64_t)bgl_get_timer_freq(bgl) / fps_lim;
 
     init(bgl);
 
-    uint64_t t = 0, tt, start_timer = bgl_get_timer(bgl);
-    int64_t d;
-    double fps;
+    uint64_t start_timer = bgl_get_timer(bgl);
+    double dt, fps;
+
+    bgl_set_target_fps(bgl, fps_lim);
 
     while (!bgl_window_should_close(bgl)) {
-        tt = bgl_get_timer(bgl);
-        d = (int64_t)(tt - t);
-        if (d < delay) {
-            struct timespec ts = {.tv_nsec = delay - d};
-            nanosleep(&ts, NULL);
-            continue;
-        }
-        t = tt;
-        fps = (double)bgl_get_timer_freq(bgl) / (double)d;
+        dt = bgl_frame_begin(bgl);
+        fps = dt > 0 ? 1.0 / dt : fps_lim;
         snprintf(title, sizeof(title), title_fmt, fps);
         bgl_set_window_title(bgl, title);
 
         bgl_poll_events(bgl);
-        draw(bgl, (float)((double)(t - start_timer) / (double)bgl_get_timer_freq(bgl)));
+        draw(bgl, (float)((double)(bgl_get_timer(bgl) - start_timer) / (double)bgl_get_timer_freq(bgl)));
+        bgl_frame_end(bgl);
     }
 
     bgl_destroy_window(bgl);
@@ -7,7 +7,6 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 
 #include <bgl/bgl.h>
 #include <string.h>
@@ -254,21 +253,13 @@ int main() {
 
     init(width, height);
 
-    int64_t delay = (int64_t)bgl_get_timer_freq(bgl) / fps_lim;
-    uint64_t t = 0, tt;
-    int64_t d;
-    double fps;
+    double dt, fps;
+
+    bgl_set_target_fps(bgl, fps_lim);
 
     while (!bgl_window_should_close(bgl)) {
-        tt = bgl_get_timer(bgl);
-        d = (int64_t)(tt - t);
-        if (d < delay) {
-            struct timespec ts = {.tv_nsec = delay - d};
-            nanosleep(&ts, NULL);
-            continue;
-        }
-        t = tt;
-        fps = (double)bgl_get_timer_freq(bgl) / (double)d;
+        dt = bgl_frame_begin(bgl);
+        fps = dt > 0 ? 1.0 / dt : fps_lim;
         snprintf(title, sizeof(title), title_fmt, fps);
         bgl_set_window_title(bgl, title);
 
@@ -277,6 +268,7 @@ int main() {
 
         bgl_draw_vertex_buffers(bgl, 0);
         bgl_swap_buffers(bgl);
+        bgl_frame_end(bgl);
     }
 
     bgl_terminate(bgl);
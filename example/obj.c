@@ -9,7 +9,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 #include <bgl/bgl.h>
 #include <bgl/bglt.h>
@@ -37,10 +36,19 @@ static int load_obj(bgl_instance bgl, const char *obj_file_path) {
     for (size_t i = obj->group_cnt; i--;)
         printf("  [%lu] \"%-*s\" i=%d (%p)\n", i, 8, obj->groups[i].name, obj->groups[i].i_cnt, obj->groups[i].indices);
 
+    bgl_mesh_stats_t before, after;
+    if (bgl_optimize_obj(obj, &before, &after))
+        printf("optimized v=%d: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, overdraw %.3f -> %.3f\n",
+               obj->v_cnt, before.acmr, after.acmr, before.atvr, after.atvr, before.overdraw, after.overdraw);
+
     int vbuf = bgl_create_vertex_buffer(bgl, obj->vertices, obj->v_cnt, 0);
     bgl_bind_model_matrix(bgl, vbuf, &obj_model);
-    for (size_t i = obj->group_cnt; i--;)
-        bgl_create_index_buffer(bgl, vbuf, obj->groups[i].indices, obj->groups[i].i_cnt, BGL_TRIANGLES);
+    for (size_t i = obj->group_cnt; i--;) {
+        int lod = bgl_generate_lod(bgl, vbuf, obj->vertices, obj->v_cnt,
+                                   obj->groups[i].indices, obj->groups[i].i_cnt, 4, 0.5f);
+        if (lod < 0)
+            return 1;
+    }
 
     return 0;
 }
@@ -94,7 +102,6 @@ int main(int argc, char **argv) {
     }
 
     int fps_lim = 60;
-    int64_t delay = (int64_t)bgl_get_timer_freq(bgl) / fps_lim;
 
     if (init(bgl, argv[1])) {
         fprintf(stderr, "init error: %s\n", strerror(errno));
@@ -102,25 +109,19 @@ int main(int argc, char **argv) {
         exit(EXIT_FAILURE);
     }
 
-    uint64_t t = 0, tt;
-    int64_t d;
-    double fps;
+    double dt, fps;
+
+    bgl_set_target_fps(bgl, fps_lim);
 
     while (!bgl_window_should_close(bgl)) {
-        tt = bgl_get_timer(bgl);
-        d = (int64_t)(tt - t);
-        if (d < delay) {
-            struct timespec ts = {.tv_nsec = delay - d};
-            nanosleep(&ts, NULL);
-            continue;
-        }
-        t = tt;
-        fps = (double)bgl_get_timer_freq(bgl) / (double)d;
+        dt = bgl_frame_begin(bgl);
+        fps = dt > 0 ? 1.0 / dt : fps_lim;
         snprintf(title, sizeof(title), title_fmt, fps);
         bgl_set_window_title(bgl, title);
 
         bgl_poll_events(bgl);
         draw(bgl, (float)fps);
+        bgl_frame_end(bgl);
     }
 
     bgl_destroy_window(bgl);
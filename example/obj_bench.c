@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined _WIN32 || defined __CYGWIN__
+# include <windows.h>
+# include <psapi.h>
+#else
+# include <sys/resource.h>
+# include <sys/wait.h>
+# include <unistd.h>
+#endif
+
+#include <bgl/bgl.h>
+#include <bgl/bglt.h>
+
+
+typedef struct {
+    long vertices;
+    long faces;
+    float quads;        // share of faces written as quads
+    int normals;
+    int groups;
+} gen_cfg;
+
+typedef struct {
+    const char *name;
+    long (*run)(const char *path);      // triangles loaded, -1 on failure
+    void (*prepare)(const char *path);  // untimed, before each run
+} loader;
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static long peak_rss_kb(void) {
+#if defined _WIN32 || defined __CYGWIN__
+    PROCESS_MEMORY_COUNTERS pmc;
+    return GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)) ? (long)(pmc.PeakWorkingSetSize >> 10) : -1;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru))
+        return -1;
+# if defined(__APPLE__)
+    return ru.ru_maxrss >> 10;
+# else
+    return ru.ru_maxrss;
+# endif
+#endif
+}
+
+static long obj_triangles(bgl_obj_t *obj) {
+    long n = 0;
+
+    if (!obj)
+        return -1;
+    for (int i = 0; i < obj->group_cnt; ++i)
+        n += obj->groups[i].i_cnt / 3;
+    bgl_destroy_obj(obj);
+
+    return n;
+}
+
+static long run_obj(const char *path) {
+    return obj_triangles(bgl_load_obj(path));
+}
+
+static long run_obj_mt(const char *path) {
+    return obj_triangles(bgl_load_obj_mt(path, 0));
+}
+
+static void count_triangles(const bgl_obj_corner_t *corners, int count, void *user) {
+    *(long *)user += count / 3;
+}
+
+static long run_stream(const char *path) {
+    long n = 0;
+    bgl_obj_stream_t stream = {.triangles = count_triangles, .user = &n};
+
+    return bgl_stream_obj(path, &stream, 0) ? n : -1;
+}
+
+static void get_cache_path(const char *path, char *cache_path, size_t size) {
+    snprintf(cache_path, size, "%s.bench.bglm", path);
+}
+
+static long run_cached(const char *path) {
+    char cache_path[4096];
+    bgl_mesh_cache_t *cache;
+    long n = 0;
+
+    get_cache_path(path, cache_path, sizeof(cache_path));
+    if (!(cache = bgl_load_obj_cached(path, cache_path)))
+        return -1;
+    for (int i = 0; i < cache->group_cnt; ++i)
+        n += cache->groups[i].i_cnt / 3;
+    bgl_close_mesh_cache(cache);
+
+    return n;
+}
+
+static void drop_cache(const char *path) {
+    char cache_path[4096];
+
+    get_cache_path(path, cache_path, sizeof(cache_path));
+    remove(cache_path);
+}
+
+static void warm_cache(const char *path) {
+    run_cached(path);
+}
+
+// the cache is timed once as a parse plus write and once as a hit
+static const loader loaders[] = {
+        {"obj", run_obj},
+        {"obj_mt", run_obj_mt},
+        {"stream", run_stream},
+        {"cache_build", run_cached, drop_cache},
+        {"cache_hit", run_cached, warm_cache},
+};
+
+/*!
+ * @brief Write a wavy grid surface, faces walk the grid cells and wrap around when asked for more.
+ */
+static long generate(const char *path, const gen_cfg *cfg, long *vertices) {
+    long side = (long)sqrt((double)cfg->vertices), faces = 0;
+    FILE *f;
+
+    if (side < 2)
+        side = 2;
+    *vertices = side * side;
+    if (!(f = fopen(path, "w")))
+        return -1;
+
+    for (long y = 0; y < side; ++y)
+        for (long x = 0; x < side; ++x)
+            fprintf(f, "v %.6f %.6f %.6f\n", (double)x, (double)y, sin(x * 0.1) * cos(y * 0.1) * 4);
+    if (cfg->normals)
+        for (long y = 0; y < side; ++y)
+            for (long x = 0; x < side; ++x)
+                fprintf(f, "vn %.6f %.6f %.6f\n",
+                        -cos(x * 0.1) * cos(y * 0.1) * 0.4, sin(x * 0.1) * sin(y * 0.1) * 0.4, 1.0);
+
+    long cells = (side - 1) * (side - 1), per_group = cfg->faces / (cfg->groups > 0 ? cfg->groups : 1) + 1;
+    unsigned seed = 1;
+    for (long c = 0, g = 0; faces < cfg->faces; ++c) {
+        long x = c % cells % (side - 1), y = c % cells / (side - 1);
+        long i0 = y * side + x + 1, i1 = i0 + 1, i2 = i1 + side, i3 = i0 + side;
+
+        if (cfg->groups > 0 && faces / per_group >= g)
+            fprintf(f, "o group%ld\n", g++);
+
+        seed = seed * 1103515245u + 12345u;
+        int quad = (seed >> 16 & 0x7FFF) < cfg->quads * 0x8000;
+        if (cfg->normals) {
+            if (quad)
+                fprintf(f, "f %ld//%ld %ld//%ld %ld//%ld %ld//%ld\n", i0, i0, i1, i1, i2, i2, i3, i3);
+            else
+                fprintf(f, "f %ld//%ld %ld//%ld %ld//%ld\nf %ld//%ld %ld//%ld %ld//%ld\n",
+                        i0, i0, i1, i1, i2, i2, i0, i0, i2, i2, i3, i3);
+        } else {
+            if (quad)
+                fprintf(f, "f %ld %ld %ld %ld\n", i0, i1, i2, i3);
+            else
+                fprintf(f, "f %ld %ld %ld\nf %ld %ld %ld\n", i0, i1, i2, i0, i2, i3);
+        }
+        faces += quad ? 1 : 2;
+    }
+
+    if (fclose(f))
+        return -1;
+
+    return faces;
+}
+
+static long file_size(const char *path) {
+    FILE *f = fopen(path, "rb");
+    long size;
+
+    if (!f)
+        return -1;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fclose(f);
+
+    return size;
+}
+
+static void bench(const loader *l, const char *path, long bytes, int repeat) {
+    double best = INFINITY;
+    long tris = -1;
+
+    for (int i = 0; i < repeat; ++i) {
+        if (l->prepare)
+            l->prepare(path);
+
+        double t = now();
+        tris = l->run(path);
+        t = now() - t;
+        if (tris < 0)
+            break;
+        if (t < best)
+            best = t;
+    }
+
+    if (tris < 0)
+        printf("%s,%s,%ld,-1,-1,-1,-1,%ld\n", l->name, path, bytes, peak_rss_kb());
+    else
+        printf("%s,%s,%ld,%ld,%.6f,%.2f,%.0f,%ld\n", l->name, path, bytes, tris, best,
+               bytes / best / 1e6, tris / best, peak_rss_kb());
+    fflush(stdout);
+}
+
+/*!
+ * @brief Each loader runs in its own process where possible, so the peak RSS is its own.
+ */
+static void bench_isolated(const loader *l, const char *path, long bytes, int repeat) {
+#if defined _WIN32 || defined __CYGWIN__
+    bench(l, path, bytes, repeat);
+#else
+    fflush(stdout);
+    pid_t pid = fork();
+
+    if (pid < 0) {
+        bench(l, path, bytes, repeat);
+    } else if (!pid) {
+        bench(l, path, bytes, repeat);
+        _exit(0);
+    } else {
+        waitpid(pid, NULL, 0);
+    }
+#endif
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [options] [file.obj ...]\n"
+            "  -v N    generated vertices (default 1000000)\n"
+            "  -f N    generated faces (default 2 per vertex)\n"
+            "  -q R    share of quads among generated faces, 0..1 (default 0)\n"
+            "  -n      write vertex normals\n"
+            "  -g N    number of groups (default 1)\n"
+            "  -r N    repeats per loader, the best time is reported (default 3)\n"
+            "  -l NAME run only this loader: obj, obj_mt, stream, cache_build, cache_hit\n"
+            "  -k      keep the generated file\n"
+            "Results are CSV on stdout: loader,file,bytes,triangles,seconds,mb_per_s,triangles_per_s,peak_rss_kb\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    gen_cfg cfg = {.vertices = 1000000, .faces = -1, .groups = 1};
+    const char *only = NULL, *files[64];
+    int repeat = 3, keep = false, file_cnt = 0;
+    char gen_path[64];
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i], *val = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (arg[0] != '-') {
+            if (file_cnt < (int)(sizeof(files) / sizeof(*files)))
+                files[file_cnt++] = arg;
+            continue;
+        }
+        if (!strcmp(arg, "-n")) {
+            cfg.normals = true;
+        } else if (!strcmp(arg, "-k")) {
+            keep = true;
+        } else if (val && !strcmp(arg, "-v")) {
+            cfg.vertices = atol(argv[++i]);
+        } else if (val && !strcmp(arg, "-f")) {
+            cfg.faces = atol(argv[++i]);
+        } else if (val && !strcmp(arg, "-q")) {
+            cfg.quads = (float)atof(argv[++i]);
+        } else if (val && !strcmp(arg, "-g")) {
+            cfg.groups = atoi(argv[++i]);
+        } else if (val && !strcmp(arg, "-r")) {
+            repeat = atoi(argv[++i]);
+        } else if (val && !strcmp(arg, "-l")) {
+            only = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (repeat < 1)
+        repeat = 1;
+    if (cfg.faces < 0)
+        cfg.faces = cfg.vertices * 2;
+
+    if (!file_cnt) {
+        snprintf(gen_path, sizeof(gen_path), "obj_bench_%ld.obj", (long)time(NULL));
+        long vertices, faces = generate(gen_path, &cfg, &vertices);
+        if (faces < 0) {
+            fprintf(stderr, "Failed to generate %s: %s\n", gen_path, strerror(errno));
+            return 1;
+        }
+        fprintf(stderr, "generated %s: %ld vertices, %ld faces, %ld bytes\n",
+                gen_path, vertices, faces, file_size(gen_path));
+        files[file_cnt++] = gen_path;
+    }
+
+    printf("loader,file,bytes,triangles,seconds,mb_per_s,triangles_per_s,peak_rss_kb\n");
+    for (int f = 0; f < file_cnt; ++f) {
+        long bytes = file_size(files[f]);
+
+        for (size_t i = 0; i < sizeof(loaders) / sizeof(*loaders); ++i)
+            if (!only || !strcmp(only, loaders[i].name))
+                bench_isolated(&loaders[i], files[f], bytes, repeat);
+
+        drop_cache(files[f]);
+    }
+
+    if (files[0] == gen_path && !keep)
+        remove(gen_path);
+
+    return 0;
+}
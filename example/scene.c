@@ -9,7 +9,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 #include <bgl/bgl.h>
 #include <bgl/bglt.h>
@@ -168,8 +167,15 @@ static int load_obj(bgl_instance bgl, const char *obj_file_path) {
     return 0;
 }
 
+static void resize_callback(bgl_instance bgl, int w, int h) {
+    width = w;
+    height = h;
+    glm_perspective(glm_rad(67.5f), bgl_get_viewport_aspect_ratio(bgl), 0.1f, 100.0f, glob_uniform.proj);
+}
+
 static int init(bgl_instance bgl, const char *obj_file_path) {
     bgl_set_key_callback(bgl, key_callback);
+    bgl_set_window_resize_callback(bgl, resize_callback);
 
     if (load_obj(bgl, obj_file_path))
         return 1;
@@ -245,13 +251,14 @@ int main(int argc, const char **argv) {
         exit(EXIT_FAILURE);
     }
 
-    char title[64];
-    char title_fmt[] = "BGL Scene | FPS: %.01f";
+    char title[96];
+    char title_fmt[] = "BGL Scene | FPS: %.01f | p99: %.02f ms | max: %.02f ms";
 
     bgl_instance bgl = bgl_init();
     if (!bgl)
         exit(EXIT_FAILURE);
 
+    bgl_set_window_resizable(bgl, true);
     if (!bgl_create_window(bgl, width, height, NULL)) {
         fprintf(stderr, "no window\n");
         bgl_terminate(bgl);
@@ -264,26 +271,21 @@ int main(int argc, const char **argv) {
         exit(EXIT_FAILURE);
     }
 
-    uint64_t t = 0, tt;
-    int64_t d;
-    double fps;
-    int64_t delay = (int64_t)bgl_get_timer_freq(bgl) / fps_lim;
+    double dt, fps;
+    bgl_frame_stats stats;
+
+    bgl_set_target_fps(bgl, fps_lim);
 
     while (!bgl_window_should_close(bgl)) {
-        tt = bgl_get_timer(bgl);
-        d = (int64_t)(tt - t);
-        if (d < delay) {
-            struct timespec ts = {.tv_nsec = delay - d};
-            nanosleep(&ts, NULL);
-            continue;
-        }
-        t = tt;
-        fps = (double)bgl_get_timer_freq(bgl) / (double)d;
-        snprintf(title, sizeof(title), title_fmt, fps);
+        dt = bgl_frame_begin(bgl);
+        fps = dt > 0 ? 1.0 / dt : fps_lim;
+        bgl_get_frame_stats(bgl, &stats);
+        snprintf(title, sizeof(title), title_fmt, fps, stats.p99 * 1e3, stats.max * 1e3);
         bgl_set_window_title(bgl, title);
 
         bgl_poll_events(bgl);
-        draw(bgl, (float)(1.0 / fps));
+        draw(bgl, (float)dt);
+        bgl_frame_end(bgl);
     }
 
     bgl_destroy_window(bgl);
@@ -186,15 +186,38 @@ typedef enum {
     BGL_REPEATE,
 } bgl_key_action;
 
+typedef enum {
+    BGL_EVENT_KEY = 1,
+    BGL_EVENT_RESIZE,
+    BGL_EVENT_CLOSE,
+} bgl_event_type;
+
+typedef enum {
+    BGL_FD_READ = 1 << 0,
+    BGL_FD_WRITE = 1 << 1,
+    BGL_FD_ERROR = 1 << 2,
+} bgl_fd_events;
+
+
+typedef enum {
+    BGL_CULL_NONE = 0,
+    BGL_CULL_BACK,
+    BGL_CULL_FRONT,
+} bgl_cull_mode;
+
 
 #define BGL_DEFINE_HANDLE(object) typedef struct object* object
 #define BGL_DEFINE_STRUCT(object) typedef struct object object
 
 BGL_DEFINE_HANDLE(bgl_instance);
 BGL_DEFINE_STRUCT(bgl_viewport);
+BGL_DEFINE_STRUCT(bgl_frame_stats);
+BGL_DEFINE_STRUCT(bgl_event);
 
 typedef void (*bgl_close_window_fn)(bgl_instance bgl);
 typedef void (*bgl_key_fn)(bgl_instance bgl, bgl_key key, unsigned scancode, bgl_key_action action, bgl_key_mods mods);
+typedef void (*bgl_fd_fn)(bgl_instance bgl, int fd, bgl_fd_events events, void *user);
+typedef void (*bgl_resize_fn)(bgl_instance bgl, int width, int height);
 
 
 struct bgl_viewport {
@@ -205,6 +228,45 @@ struct bgl_viewport {
 };
 
 
+#define BGL_FRAME_STATS_BINS 64
+
+/*!
+ * @brief Frame times of the recent frames in seconds, measured between bgl_swap_buffers calls.
+ * Histogram bins are p50 / 16 wide starting at 0, the last one also collects all longer frames.
+ */
+struct bgl_frame_stats {
+    int count;
+    double mean;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+    double bin_width;
+    int histogram[BGL_FRAME_STATS_BINS];
+};
+
+
+/*!
+ * @brief Queued input event, time is in bgl_get_timer ticks of when it happened.
+ */
+struct bgl_event {
+    bgl_event_type type;
+    uint64_t time;
+    union {
+        struct {
+            bgl_key key;
+            unsigned scancode;
+            bgl_key_action action;
+            bgl_key_mods mods;
+        } key;
+        struct {
+            int width;
+            int height;
+        } size;
+    };
+};
+
+
 BGL_API bgl_instance bgl_init();
 BGL_API void bgl_terminate(bgl_instance bgl);
 
@@ -213,36 +275,72 @@ BGL_API void bgl_set_time(bgl_instance bgl, double t);
 BGL_API uint64_t bgl_get_timer(bgl_instance bgl);
 BGL_API uint64_t bgl_get_timer_freq(bgl_instance bgl);
 
+BGL_API void bgl_set_target_fps(bgl_instance bgl, double fps);
+BGL_API double bgl_frame_begin(bgl_instance bgl);
+BGL_API int bgl_frame_end(bgl_instance bgl);
+BGL_API uint64_t bgl_get_missed_frames(bgl_instance bgl);
+BGL_API int bgl_get_frame_stats(bgl_instance bgl, bgl_frame_stats *stats);
+BGL_API void bgl_reset_frame_stats(bgl_instance bgl);
+
 BGL_API int bgl_create_window(bgl_instance bgl, int width, int height, const char *title);
 BGL_API void bgl_destroy_window(bgl_instance bgl);
 BGL_API int bgl_window_should_close(bgl_instance bgl);
 BGL_API void bgl_set_window_should_close(bgl_instance bgl, int val);
 BGL_API void bgl_show_window(bgl_instance bgl);
 BGL_API void bgl_set_window_title(bgl_instance bgl, const char *title);
+BGL_API void bgl_set_window_resizable(bgl_instance bgl, int val);
+BGL_API void bgl_get_window_size(bgl_instance bgl, int *width, int *height);
+BGL_API void bgl_get_framebuffer_size(bgl_instance bgl, int *width, int *height);
 BGL_API void bgl_swap_buffers(bgl_instance bgl);
 
 BGL_API int bgl_set_window_close_callback(bgl_instance bgl, bgl_close_window_fn callback);
 BGL_API int bgl_set_key_callback(bgl_instance bgl, bgl_key_fn callback);
+BGL_API int bgl_set_window_resize_callback(bgl_instance bgl, bgl_resize_fn callback);
+
+BGL_API bgl_key_action bgl_get_key(bgl_instance bgl, bgl_key key);
+BGL_API uint64_t bgl_get_key_time(bgl_instance bgl, bgl_key key);
+BGL_API int bgl_set_event_queue(bgl_instance bgl, int capacity);
+BGL_API int bgl_get_events(bgl_instance bgl, bgl_event *events, int max);
 
 BGL_API void bgl_poll_events(bgl_instance bgl);
 BGL_API void bgl_wait_events(bgl_instance bgl);
 BGL_API void bgl_wait_events_timeout(bgl_instance bgl, double timeout);
 BGL_API void bgl_send_empty_event(bgl_instance bgl);
+BGL_API int bgl_watch_fd(bgl_instance bgl, int fd, bgl_fd_events events, bgl_fd_fn callback, void *user);
+BGL_API int bgl_unwatch_fd(bgl_instance bgl, int fd);
+BGL_API int bgl_get_event_fd(bgl_instance bgl);
 
 BGL_API int bgl_create_vertex_buffer(bgl_instance bgl, const vertex *vertices, int count, bgl_drawing_modes mode);
+BGL_API int bgl_create_vertex_buffer_packed(bgl_instance bgl, const vertex_packed *vertices, int count, mat4 dequant,
+                                            bgl_drawing_modes mode);
+BGL_API int bgl_pack_vertices(const vertex *src, int count, vertex_packed *dst, mat4 dequant);
+BGL_API int bgl_unpack_vertices(const vertex_packed *src, int count, vertex *dst, mat4 dequant);
 BGL_API void bgl_remove_vertex_buffer(bgl_instance bgl, int id);
 BGL_API void bgl_clear_vertex_bufers(bgl_instance bgl);
 
 BGL_API int bgl_create_index_buffer(bgl_instance bgl, int vbuf_id, const vindex *indices, int count, bgl_drawing_modes mode);
 BGL_API void bgl_remove_index_buffer(bgl_instance bgl, int ibuf_id, int with_vbuf);
 BGL_API void bgl_clear_index_buffers(bgl_instance bgl);
+BGL_API int bgl_build_index_buffer_meshlets(bgl_instance bgl, int ibuf_id, int max_tris);
+
+BGL_API int bgl_create_lod(bgl_instance bgl, const int *ibuf_ids, const float *errors, int count);
+BGL_API void bgl_remove_lod(bgl_instance bgl, int lod_id, int with_ibufs);
+BGL_API void bgl_clear_lods(bgl_instance bgl);
+BGL_API int bgl_set_lod_threshold(bgl_instance bgl, int lod_id, float pixels);
 
 BGL_API void bgl_set_viewport(bgl_instance bgl, bgl_viewport *viewport);
 BGL_API float bgl_get_viewport_aspect_ratio(bgl_instance bgl);
 BGL_API void bgl_set_global_uniform(bgl_instance bgl, uniform *uniform, int mode);
 BGL_API int bgl_bind_model_matrix(bgl_instance bgl, int vbuf_id, mat4 *model);
+BGL_API int bgl_set_contribution_cull(bgl_instance bgl, int vbuf_id, float min_pixels);
+BGL_API int bgl_set_vertex_buffer_cull_mode(bgl_instance bgl, int vbuf_id, bgl_cull_mode mode);
+BGL_API int bgl_set_index_buffer_cull_mode(bgl_instance bgl, int ibuf_id, bgl_cull_mode mode);
 
+BGL_API void bgl_begin_frame(bgl_instance bgl);
+BGL_API void bgl_end_frame(bgl_instance bgl);
 BGL_API void bgl_draw_vertex_buffers(bgl_instance bgl, bgl_drawing_modes mode);
 BGL_API void bgl_draw_index_buffers(bgl_instance bgl, bgl_drawing_modes mode);
+BGL_API int bgl_draw_vertex_buffer_range(bgl_instance bgl, int vbuf_id, int first, int count, bgl_drawing_modes mode);
+BGL_API int bgl_draw_index_buffer_range(bgl_instance bgl, int ibuf_id, int first, int count, bgl_drawing_modes mode);
 
 #endif // BGL_BGL_H
@@ -8,6 +8,8 @@
 #ifndef BGL_BGLM_H
 #define BGL_BGLM_H
 
+#include <stdint.h>
+
 #include <cglm/cglm.h>
 #include <cglm/struct.h>
 #include <cglm/types-struct.h>
@@ -19,6 +21,17 @@ typedef struct {
     vec3 normal;
 } vertex;
 
+/*!
+ * @brief Compact 16 bytes vertex.
+ * Positions are snorm16 mapped to model space by the buffer dequantisation matrix,
+ * color is RGBA8 (R in the low byte) and the normal is octahedral snorm16.
+ */
+typedef struct {
+    int16_t pos[4];
+    uint32_t color;
+    int16_t normal[2];
+} vertex_packed;
+
 typedef struct {
     int idx;
     vec4 color;
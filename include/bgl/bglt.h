@@ -10,6 +10,8 @@
 #define BGL_BGLT_H
 
 
+#include <stdio.h>
+
 #include <bgl/bgl.h>
 
 
@@ -17,6 +19,10 @@ typedef struct {
     char *name;
     vindex *indices;
     int i_cnt;
+    vec3 min;       // bounds of the vertices referenced by the group
+    vec3 max;
+    vec3 center;    // bounding sphere
+    float radius;
 } bgl_obj_group_t;
 
 typedef struct {
@@ -26,7 +32,125 @@ typedef struct {
     int group_cnt;
 } bgl_obj_t;
 
+typedef struct {
+    int v, vt, vn;      // 0-based, -1 when absent
+} bgl_obj_corner_t;
+
+/*!
+ * @brief Streaming OBJ callbacks, any of them may be NULL.
+ * Data arrives in file order in batches; triangles only reference vertices and normals already passed.
+ */
+typedef struct {
+    void (*vertices)(const vertex *vertices, int count, void *user);
+    void (*normals)(const vec3 *normals, int count, void *user);
+    void (*group)(const char *name, void *user);
+    void (*triangles)(const bgl_obj_corner_t *corners, int count, void *user);
+    void *user;
+} bgl_obj_stream_t;
+
+typedef struct {
+    const char *name;
+    const vindex *indices;
+    int i_cnt;
+    vec3 min;       // bounds of the vertices referenced by the group
+    vec3 max;
+} bgl_mesh_cache_group_t;
+
+/*!
+ * @brief Mesh cache mapped read only, the arrays can be passed to the buffer constructors as is.
+ */
+typedef struct {
+    const vertex *vertices;
+    int v_cnt;
+    const bgl_mesh_cache_group_t *groups;
+    int group_cnt;
+
+    void *map;
+    size_t map_size;
+} bgl_mesh_cache_t;
+
+typedef struct {
+    const vertex *vertices;     // may point into the mapped file when its layout matches, pos[3] is then arbitrary
+    int v_cnt;
+    vindex *indices;            // NULL for a non indexed primitive
+    int i_cnt;
+    bgl_drawing_modes mode;
+} bgl_glb_primitive_t;
+
+typedef struct {
+    char *name;
+    bgl_glb_primitive_t *primitives;
+    int prim_cnt;
+} bgl_glb_mesh_t;
+
+typedef struct {
+    mat4 model;     // world transform, stays valid for bgl_bind_model_matrix until bgl_destroy_glb
+    char *name;
+    int mesh;
+} bgl_glb_node_t;
+
+/*!
+ * @brief Binary glTF scene, nodes are the mesh instances of the default scene in traversal order.
+ */
+typedef struct {
+    bgl_glb_mesh_t *meshes;
+    int mesh_cnt;
+    bgl_glb_node_t *nodes;
+    int node_cnt;
+    int buffer_cnt;     // primitives over all nodes, one buffer each
+
+    void *map;
+    size_t map_size;
+} bgl_glb_t;
+
+typedef struct {
+    float acmr;     // average cache miss ratio: transformed vertices per triangle
+    float atvr;     // average transform to vertex ratio: transformed per unique vertex
+    float overdraw; // shaded pixels per covered pixel
+} bgl_mesh_stats_t;
+
+/*!
+ * @brief Input callback: fills up to `size` bytes, returns the count, 0 at the end or -1 with errno set.
+ * gzip and zstd input is detected by its magic and decoded on the fly.
+ */
+typedef ptrdiff_t (*bgl_read_fn)(void *user, void *buf, size_t size);
+
+/*!
+ * @brief Called from the event functions on the thread that polls events.
+ * The callback owns `obj` and releases it with bgl_destroy_obj; on failure `obj` is NULL and `err` is set.
+ */
+typedef void (*bgl_obj_loaded_fn)(bgl_instance bgl, bgl_obj_t *obj, int err, void *user);
+
 BGL_API bgl_obj_t *bgl_load_obj(const char *path);
+BGL_API bgl_obj_t *bgl_load_obj_mt(const char *path, int threads);
+BGL_API bgl_obj_t *bgl_load_obj_read(bgl_read_fn read, void *user, int threads);
+BGL_API bgl_obj_t *bgl_load_obj_file(FILE *file, int threads);
+BGL_API int bgl_stream_obj(const char *path, const bgl_obj_stream_t *stream, int batch);
+BGL_API int bgl_stream_obj_read(bgl_read_fn read, void *user, const bgl_obj_stream_t *stream, int batch);
+BGL_API bgl_obj_t *bgl_load_ply(const char *path);
+BGL_API bgl_obj_t *bgl_load_stl(const char *path);
+BGL_API bgl_glb_t *bgl_load_glb(const char *path);
+BGL_API int bgl_create_glb_buffers(bgl_instance bgl, bgl_glb_t *glb, int *ids);
+BGL_API void bgl_destroy_glb(bgl_glb_t *glb);
+BGL_API int bgl_load_obj_async(bgl_instance bgl, const char *path, bgl_obj_loaded_fn callback, void *user);
 BGL_API void bgl_destroy_obj(bgl_obj_t *obj);
 
+BGL_API int bgl_write_mesh_cache(const char *path, const bgl_obj_t *obj, const char *src_path);
+BGL_API bgl_mesh_cache_t *bgl_open_mesh_cache(const char *path, const char *src_path);
+BGL_API bgl_mesh_cache_t *bgl_load_obj_cached(const char *obj_path, const char *cache_path);
+BGL_API void bgl_close_mesh_cache(bgl_mesh_cache_t *cache);
+
+BGL_API int bgl_analyze_mesh(const vertex *vertices, int v_cnt, const vindex *indices, int i_cnt,
+                             bgl_mesh_stats_t *stats);
+BGL_API int bgl_optimize_vertex_cache(vindex *indices, int i_cnt, int v_cnt);
+BGL_API int bgl_optimize_overdraw(const vertex *vertices, int v_cnt, vindex *indices, int i_cnt, float threshold);
+BGL_API int bgl_deduplicate_vertices(vertex *vertices, int v_cnt, vindex *indices, int i_cnt);
+BGL_API int bgl_optimize_vertex_fetch(vertex *vertices, int v_cnt, vindex *indices, int i_cnt);
+BGL_API int bgl_optimize_obj(bgl_obj_t *obj, bgl_mesh_stats_t *before, bgl_mesh_stats_t *after);
+
+BGL_API int bgl_simplify_mesh(const vertex *vertices, int v_cnt, const vindex *indices, int i_cnt,
+                              vindex *dst, int target_i_cnt, float target_error, float *result_error);
+BGL_API int bgl_generate_lod(bgl_instance bgl, int vbuf_id, const vertex *vertices, int v_cnt,
+                             const vindex *indices, int i_cnt, int levels, float ratio);
+
 #endif // BGL_BGLT_H
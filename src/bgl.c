@@ -23,6 +23,12 @@ BGL_API bgl_instance bgl_init() {
         return NULL;
     }
 
+    if (!init_platform_mutex(&bgl->loader.lock)) {
+        fprintf(stderr, "Failed to init BGL: unable to create the loader lock\n");
+        free(bgl);
+        return NULL;
+    }
+
     if (!init_platform(bgl)) {
         bgl_terminate(bgl);
         return NULL;
@@ -48,10 +54,13 @@ BGL_API bgl_instance bgl_init() {
 }
 
 BGL_API void bgl_terminate(bgl_instance bgl) {
+    finish_load_jobs(bgl);
+    bgl_clear_lods(bgl);
     bgl_clear_index_buffers(bgl);
     bgl_clear_vertex_bufers(bgl);
     clear_helper_buf(bgl);
     bgl_destroy_window(bgl);
     terminate_platform(bgl);
+    destroy_platform_mutex(&bgl->loader.lock);
     free(bgl);
 }
@@ -28,3 +28,14 @@ BGL_API int bgl_set_key_callback(bgl_instance bgl, bgl_key_fn callback) {
 
     return true;
 }
+
+BGL_API int bgl_set_window_resize_callback(bgl_instance bgl, bgl_resize_fn callback) {
+    if (!bgl->window) {
+        fprintf(stderr, "Invalid window\n");
+        return false;
+    }
+
+    bgl->window->callbacks.resize = callback;
+
+    return true;
+}
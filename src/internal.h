@@ -8,10 +8,12 @@
 #ifndef BGL_INTERNAL_H
 #define BGL_INTERNAL_H
 
+#include <stdatomic.h>
 #include <stdint.h>
 
 #include <bgl/bgl.h>
 #include <bgl/bglm.h>
+#include <bgl/bglt.h>
 
 
 #if defined(__GNUC__)
@@ -32,6 +34,9 @@ BGL_DEFINE_STRUCT(bgl_fb_cfg);
 BGL_DEFINE_STRUCT(bgl_render_cfg);
 BGL_DEFINE_HANDLE(bgl_vertex_buffer);
 BGL_DEFINE_HANDLE(bgl_index_buffer);
+BGL_DEFINE_HANDLE(bgl_lod);
+BGL_DEFINE_HANDLE(bgl_load_job);
+BGL_DEFINE_HANDLE(bgl_reader);
 BGL_DEFINE_STRUCT(bgl_viewport_internal);
 
 
@@ -73,8 +78,17 @@ struct bgl_window {
     struct {
         bgl_close_window_fn close;
         bgl_key_fn key;
+        bgl_resize_fn resize;
     } callbacks;
 
+    // events kept for bgl_get_events, the oldest is dropped when full
+    struct {
+        bgl_event *items;
+        int cap;
+        int head;
+        int cnt;
+    } queue;
+
     bgl_platform_window platform;
 };
 
@@ -90,6 +104,8 @@ struct bgl_viewport_internal {
     float oy;
     float oz;
     float aspect_ratio;
+
+    bgl_viewport src;   // as last set, rescaled on window resize
 };
 
 typedef struct {
@@ -107,13 +123,25 @@ typedef struct {
 struct bgl_vertex_buffer {
     bgl_vertex_buffer next;
     vertex *vertices;
+    vertex_packed *packed;  // either vertices or packed is set
+    mat4 dequant;
     int vitem_off;
     int count;
     int id;
     int render_mode;
     mat4 *model_m;
+    vec4 sphere;    // center, radius in model space
+    float min_pixels;   // contribution culling, 0 disables
+    int cull_mode;
 };
 
+typedef struct {
+    int first;
+    int count;
+    vec4 sphere;    // center, radius
+    vec4 cone;      // axis, cutoff
+} meshlet;
+
 struct bgl_index_buffer {
     bgl_index_buffer next;
     bgl_vertex_buffer vbuf;
@@ -121,29 +149,48 @@ struct bgl_index_buffer {
     int count;
     int id;
     int render_mode;
+    meshlet *meshlets;
+    int meshlet_cnt;
+    bgl_lod lod;
+    int cull_mode;
 };
 
-typedef struct {
-    mat3 tri;
-    vec4 color;
-    float avg_z;
-    int n;
-} vtx_item;
+struct bgl_lod {
+    bgl_lod next;
+    bgl_index_buffer *levels;   // finest first
+    float *errors;              // object space, ascending
+    int level_cnt;
+    int id;
+    float threshold;            // pixels
+    bgl_index_buffer selected;
+};
 
+/*!
+ * @brief Primitive record of the clip/sort/raster stream.
+ * Indices are absolute in the vertex helper buffer; the primitive size (1..3)
+ * lives in the top bits of the first one and the cull mode in those of the second.
+ */
 typedef struct {
-    ivec3 tri;
-    vec4 color;
+    uint32_t tri[3];
+    uint32_t color;     // ARGB
     float avg_z;
-    int v_off;
-    int n;
 } idx_item;
 
+#define IDX_ITEM_PRIM_SHIFT 30
+#define IDX_ITEM_CULL_SHIFT 30
+#define IDX_ITEM_IDX_MASK ((1u << IDX_ITEM_PRIM_SHIFT) - 1)
+#define IDX_ITEM_PRIM(item) ((int)((item)->tri[0] >> IDX_ITEM_PRIM_SHIFT))
+#define IDX_ITEM_CULL(item) ((int)((item)->tri[1] >> IDX_ITEM_CULL_SHIFT))
+#define IDX_ITEM_IDX(item, k) ((item)->tri[k] & IDX_ITEM_IDX_MASK)
+
 typedef struct {
     void *buf;
     int buf_sz;
     int cnt;
 } helper_buf;
 
+#define FRAME_STATS_SIZE 512
+
 #define HELP_BUF_INIT { .buf_sz = 512 }
 #define HELP_BUF (helper_buf)HELP_BUF_INIT
 
@@ -155,6 +202,23 @@ struct bgl_instance {
         BGL_LIB_PLATFORM_TIMER
     } timer;
 
+    // frame limiter, all values in timer ticks
+    struct {
+        uint64_t period;
+        uint64_t start;
+        uint64_t deadline;
+        uint64_t slack;
+        uint64_t missed;
+    } pacing;
+
+    // frame times in timer ticks, written by bgl_swap_buffers only, read from any thread
+    struct {
+        uint64_t last;
+        atomic_uint_fast64_t head;
+        atomic_uint_fast64_t base;
+        atomic_uint_fast64_t times[FRAME_STATS_SIZE];
+    } stats;
+
     struct {
         bgl_window_cfg window;
         bgl_fb_cfg framebuffer;
@@ -171,39 +235,91 @@ struct bgl_instance {
 
         void (*destroy_render)(bgl_instance);
         void (*swap_buffers)(bgl_instance);
+        int (*resize_framebuffer)(bgl_instance, int width, int height);
 
-        void (*draw_pixel)(bgl_instance, const ivec3 v, const vec4 color);
-        void (*draw_line)(bgl_instance, const ivec3 a, const ivec3 b, const vec4 color);
-        void (*draw_triangle)(bgl_instance, const ivec3 a, const ivec3 b, const ivec3 c, const vec4 color);
-        void (*draw_fill_triangle)(bgl_instance, const ivec3 a, const ivec3 b, const ivec3 c, const vec4 color);
+        void (*draw_pixel)(bgl_instance, const ivec3 v, uint32_t color);
+        void (*draw_line)(bgl_instance, const ivec3 a, const ivec3 b, uint32_t color);
+        void (*draw_triangle)(bgl_instance, const ivec3 a, const ivec3 b, const ivec3 c, uint32_t color);
+        void (*draw_fill_triangle)(bgl_instance, const ivec3 a, const ivec3 b, const ivec3 c, uint32_t color);
     } dev;
 
     bgl_vertex_buffer vertex_buffer;
     int vbuf_cnt;
     bgl_index_buffer index_buffer;
     int ibuf_cnt;
+    bgl_lod lod;
+    int lod_cnt;
 
     bgl_viewport_internal viewport;
 
+    // per frame state shared by all draws between bgl_begin_frame and bgl_end_frame
+    struct {
+        int active;
+        mat4 vp;
+        vec4 camera;
+        vec4 light;
+        vec4 planes[6];
+        vertex_item *vertices;
+    } frame;
+
     uniform_p glob_uniform;
     int glob_uniform_mode;
+
+    // background loads, finished ones are dispatched by the event functions
+    struct {
+        bgl_platform_mutex lock;
+        bgl_load_job jobs;
+    } loader;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void input_key(bgl_instance bgl, bgl_key key, unsigned scancode, bgl_key_action action, bgl_key_mods mods);
+void input_key(bgl_instance bgl, bgl_key key, unsigned scancode, bgl_key_action action, bgl_key_mods mods,
+               uint64_t time);
 void input_window_close_request(bgl_instance bgl);
+void input_window_resize(bgl_instance bgl, int old_width, int old_height, int width, int height);
 
 void loc_to_dev(mat4 vp, vec4 src, vec3 dst);
 void dev_to_fb(bgl_viewport_internal *viewport, vec3 src, vec3 dst);
 void loc_to_fb(mat4 vp, bgl_viewport_internal *viewport, vec4 src, vec3 dst);
 void triangle_normal(vec3 a, vec3 b, vec3 c, vec3 dst);
 
-idx_item *push_back_helper_buf_idx(bgl_instance bgl, int v_off, ivec3 idxs, vec4 color, int n);
+float face_light(vec3 norm, vec4 light, int cull_mode);
+idx_item *push_back_helper_buf_idx(bgl_instance bgl, int v_off, ivec3 idxs, const vec4 color, int n, int cull_mode);
 void clear_helper_buf(bgl_instance bgl);
 
+float vertex_buf_pixel_scale(bgl_instance bgl, bgl_vertex_buffer vbuf, vec4 camera);
+int vertex_buf_contributes(bgl_instance bgl, bgl_vertex_buffer vbuf);
+
 void prepare_buffers(bgl_instance bgl, vec4 camera, vec4 light, mat4 vp, vertex_item **vhb_buf);
 void draw_buffers(bgl_instance bgl, mat4 vp);
 
+int meshlet_visible(const meshlet *m, mat4 model, float scale, vec4 planes[6], vec4 camera, int cone_cull);
+float model_max_scale(mat4 model);
+
+void oct_decode(const int16_t src[2], vec3 dst);
+void unpack_rgba8(uint32_t c, vec4 dst);
+void vertex_buf_position(bgl_vertex_buffer buf, int i, vec4 dst);
+float *vertex_buf_color(bgl_vertex_buffer buf, int i, vec4 tmp);
+void transform_packed_vertices(bgl_vertex_buffer buf, mat4 *model, vertex_item *dst);
+
+void select_lods(bgl_instance bgl, vec4 camera);
+void detach_lod_level(bgl_index_buffer ibuf);
+
+void record_frame_time(bgl_instance bgl);
+
+void dispatch_loaded_objs(bgl_instance bgl);
+void finish_load_jobs(bgl_instance bgl);
+
+bgl_reader open_reader(ptrdiff_t (*read)(void *user, void *buf, size_t size), void *user);
+ptrdiff_t reader_read(bgl_reader r, void *buf, size_t size);
+char *reader_read_all(bgl_reader r, size_t *size);
+int reader_is_compressed(bgl_reader r);
+void close_reader(bgl_reader r);
+ptrdiff_t read_stdio(void *user, void *buf, size_t size);
+
+int compute_obj_normals(bgl_obj_t *obj);
+void compute_obj_bounds(bgl_obj_t *obj);
+
 
 #endif // BGL_INTERNAL_H
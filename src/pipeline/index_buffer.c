@@ -40,7 +40,10 @@ static void remove_index_buf(bgl_instance bgl, int id, int with_vbuf) {
             bgl_index_buffer next = (*b)->next;
             if (with_vbuf)
                 bgl_remove_vertex_buffer(bgl, (*b)->vbuf->id);
+            if ((*b)->lod)
+                detach_lod_level(*b);
             free((*b)->indices);
+            free((*b)->meshlets);
             free(*b);
             *b = next;
             --bgl->ibuf_cnt;
@@ -55,47 +58,51 @@ static void clear_index_buf(bgl_instance bgl) {
 
     while (b) {
         bgl_index_buffer next = b->next;
+        if (b->lod)
+            detach_lod_level(b);
         free(b->indices);
+        free(b->meshlets);
         free(b);
         b = next;
     }
     bgl->ibuf_cnt = 0;
 }
 
-static void draw_points(bgl_instance bgl, bgl_index_buffer buf, vertex_item *vertices) {
+static void draw_points(bgl_instance bgl, bgl_index_buffer buf, vertex_item *vertices, int first, int count) {
     ivec3 idxs;
 
-    for (int i = buf->count; i--;) {
+    for (int i = first + count; i-- > first;) {
         idxs[0] = buf->indices[i].idx;
 
         vertices[idxs[0]].used = 1;
 
-        push_back_helper_buf_idx(bgl, buf->vbuf->vitem_off, idxs, buf->indices[i].color, 1);
+        push_back_helper_buf_idx(bgl, buf->vbuf->vitem_off, idxs, buf->indices[i].color, 1, BGL_CULL_NONE);
     }
 }
 
-static void draw_lines(bgl_instance bgl, bgl_index_buffer buf, vertex_item *vertices, bgl_drawing_modes mode) {
+static void draw_lines(bgl_instance bgl, bgl_index_buffer buf, vertex_item *vertices, int first, int count,
+                       bgl_drawing_modes mode) {
     ivec3 idxs;
     int inc = (mode == BGL_LINES) ? 2 : 1;
 
-    for (int i = 0; i < buf->count - 1; i += inc) {
+    for (int i = first; i < first + count - 1; i += inc) {
         idxs[0] = buf->indices[i].idx;
         idxs[1] = buf->indices[i + 1].idx;
 
         vertices[idxs[0]].used = vertices[idxs[1]].used = 1;
 
-        push_back_helper_buf_idx(bgl, buf->vbuf->vitem_off, idxs, buf->indices[i].color, 2);
+        push_back_helper_buf_idx(bgl, buf->vbuf->vitem_off, idxs, buf->indices[i].color, 2, BGL_CULL_NONE);
     }
 
     if (mode == BGL_LINES_LOOP) {
-        idxs[0] = buf->indices[0].idx;
+        idxs[0] = buf->indices[first].idx;
 
-        push_back_helper_buf_idx(bgl, buf->vbuf->vitem_off, idxs, buf->indices[0].color, 2);
+        push_back_helper_buf_idx(bgl, buf->vbuf->vitem_off, idxs, buf->indices[first].color, 2, BGL_CULL_NONE);
     }
 }
 
-static void draw_triangles(bgl_instance bgl, bgl_index_buffer buf, vertex_item *vertices, vec4 camera, vec4 light, bgl_drawing_modes mode) {
-    vec3 ray;
+static void draw_triangles(bgl_instance bgl, bgl_index_buffer buf, vertex_item *vertices, int first, int count,
+                           vec4 light, bgl_drawing_modes mode) {
     ivec3 idxs;
 
     vec4 color;
@@ -103,9 +110,10 @@ static void draw_triangles(bgl_instance bgl, bgl_index_buffer buf, vertex_item *
     vec3 light_color = GLM_VEC3_ONE_INIT;
     vec3 diffuse;
 
-    int is_strip = mode == BGL_TRIANGLES_STRIP, strip = 0, inc = is_strip ? 1 : 3;
+    // odd strip tris are flipped, counted from the start of the buffer
+    int is_strip = mode == BGL_TRIANGLES_STRIP, strip = is_strip && (first & 1), inc = is_strip ? 1 : 3;
 
-    for (int i = 0; i < buf->count - 2; i += inc) {
+    for (int i = first; i < first + count - 2; i += inc) {
         idxs[0] = buf->indices[i + (strip ? 1 : 0)].idx;
         idxs[1] = buf->indices[i + (strip ? 0 : 1)].idx;
         idxs[2] = buf->indices[i + 2].idx;
@@ -116,24 +124,21 @@ static void draw_triangles(bgl_instance bgl, bgl_index_buffer buf, vertex_item *
                         vertices[idxs[2]].vtx,
                         norm);
 
-        // back-face culling
-        glm_vec3_sub(vertices[idxs[0]].vtx, camera, ray);
-        if (glm_vec3_dot(norm, ray) >= 0)
-            continue;
-
-        float light_intencity = glm_max(glm_vec3_dot(norm, light), 0);
+        // faces are culled after projection, see draw_buffers
+        float light_intencity = face_light(norm, light, buf->cull_mode);
         glm_vec3_scale(light_color, light_intencity, diffuse);
         glm_vec3_mul(diffuse, buf->indices[i].color, color);
+        color[3] = buf->indices[i].color[3];
 //        glm_vec3_clamp(color, 0, 1);
 
         vertices[idxs[0]].used = vertices[idxs[1]].used = vertices[idxs[2]].used = 1;
 
-        push_back_helper_buf_idx(bgl, buf->vbuf->vitem_off, idxs, color, 3);
+        push_back_helper_buf_idx(bgl, buf->vbuf->vitem_off, idxs, color, 3, buf->cull_mode);
     }
 }
 
-static void draw_triangles_fan(bgl_instance bgl, bgl_index_buffer buf, vertex_item *vertices, vec4 camera, vec4 light) {
-    vec3 ray;
+static void draw_triangles_fan(bgl_instance bgl, bgl_index_buffer buf, vertex_item *vertices, int first, int count,
+                               vec4 light) {
     ivec3 idxs;
 
     vec4 color;
@@ -141,10 +146,10 @@ static void draw_triangles_fan(bgl_instance bgl, bgl_index_buffer buf, vertex_it
     vec3 light_color = GLM_VEC3_ONE_INIT;
     vec3 diffuse;
 
-    idxs[0] = buf->indices[0].idx;
+    idxs[0] = buf->indices[first].idx;
     vertices[idxs[0]].used = 1;
 
-    for (int i = 1; i < buf->count - 1; ++i) {
+    for (int i = first + 1; i < first + count - 1; ++i) {
         idxs[1] = buf->indices[i].idx;
         idxs[2] = buf->indices[i + 1].idx;
 
@@ -153,19 +158,70 @@ static void draw_triangles_fan(bgl_instance bgl, bgl_index_buffer buf, vertex_it
                         vertices[idxs[2]].vtx,
                         norm);
 
-        // back-face culling
-        glm_vec3_sub(vertices[idxs[0]].vtx, camera, ray);
-        if (glm_vec3_dot(norm, ray) >= 0)
-            continue;
-
-        float light_intencity = glm_max(glm_vec3_dot(norm, light), 0);
+        // faces are culled after projection, see draw_buffers
+        float light_intencity = face_light(norm, light, buf->cull_mode);
         glm_vec3_scale(light_color, light_intencity, diffuse);
         glm_vec3_mul(diffuse, buf->indices[i].color, color);
+        color[3] = buf->indices[i].color[3];
 //        glm_vec3_clamp(color, 0, 1);
 
         vertices[idxs[0]].used = vertices[idxs[1]].used = 1;
 
-        push_back_helper_buf_idx(bgl, buf->vbuf->vitem_off, idxs, color, 3);
+        push_back_helper_buf_idx(bgl, buf->vbuf->vitem_off, idxs, color, 3, buf->cull_mode);
+    }
+}
+
+static void draw_meshlets(bgl_instance bgl, bgl_index_buffer buf, vertex_item *vertices, int first, int count,
+                          vec4 planes[6], vec4 camera, vec4 light) {
+    mat4 *model = buf->vbuf->model_m ? : bgl->glob_uniform.model;
+    mat4 identity = GLM_MAT4_IDENTITY_INIT;
+
+    if (!model)
+        model = &identity;
+
+    float scale = model_max_scale(*model);
+
+    // whole clusters are rejected before any per triangle work
+    for (meshlet *m = buf->meshlets; m < &buf->meshlets[buf->meshlet_cnt]; ++m) {
+        int lo = m->first > first ? m->first : first;
+        int hi = m->first + m->count < first + count ? m->first + m->count : first + count;
+
+        if (lo < hi && meshlet_visible(m, *model, scale, planes, camera, buf->cull_mode == BGL_CULL_BACK))
+            draw_triangles(bgl, buf, vertices, lo, hi - lo, light, BGL_TRIANGLES);
+    }
+}
+
+static void draw_index_buf(bgl_instance bgl, bgl_index_buffer buf, int first, int count, bgl_drawing_modes mode) {
+    bgl_drawing_modes true_mode = mode ? : buf->render_mode;
+    vertex_item *vertices = &bgl->frame.vertices[buf->vbuf->vitem_off];
+
+    if (!vertex_buf_contributes(bgl, buf->vbuf))
+        return;
+
+    switch (true_mode) {
+    case BGL_POINTS:
+        draw_points(bgl, buf, vertices, first, count);
+        break;
+    case BGL_LINES:
+    case BGL_LINES_STRIP:
+    case BGL_LINES_LOOP:
+        draw_lines(bgl, buf, vertices, first, count, true_mode);
+        break;
+    case BGL_TRIANGLES:
+        if (buf->meshlets)
+            draw_meshlets(bgl, buf, vertices, first, count, bgl->frame.planes, bgl->frame.camera, bgl->frame.light);
+        else
+            draw_triangles(bgl, buf, vertices, first, count, bgl->frame.light, true_mode);
+        break;
+    case BGL_TRIANGLES_STRIP:
+        draw_triangles(bgl, buf, vertices, first, count, bgl->frame.light, true_mode);
+        break;
+    case BGL_TRIANGLES_FAN:
+        draw_triangles_fan(bgl, buf, vertices, first, count, bgl->frame.light);
+        break;
+    default:
+        fprintf(stderr, "Invalid drawing mode: 0x%04X\n", true_mode);
+        break;
     }
 }
 
@@ -199,12 +255,28 @@ BGL_API int bgl_create_index_buffer(bgl_instance bgl, int vbuf_id, const vindex
     buf->count = count;
     buf->id = new_id++;
     buf->render_mode = mode;
+    buf->meshlets = NULL;
+    buf->meshlet_cnt = 0;
+    buf->lod = NULL;
+    buf->cull_mode = BGL_CULL_BACK;
 
     insert_index_buf(bgl, buf);
 
     return buf->id;
 }
 
+BGL_API int bgl_set_index_buffer_cull_mode(bgl_instance bgl, int ibuf_id, bgl_cull_mode mode) {
+    for (bgl_index_buffer b = bgl->index_buffer; b; b = b->next) {
+        if (b->id == ibuf_id) {
+            b->cull_mode = mode;
+            return true;
+        }
+    }
+    fprintf(stderr, "bgl_set_index_buffer_cull_mode: Invalid index buffer ID: %i\n", ibuf_id);
+
+    return false;
+}
+
 BGL_API void bgl_remove_index_buffer(bgl_instance bgl, int ibuf_id, int with_vbuf) {
     remove_index_buf(bgl, ibuf_id, with_vbuf);
 }
@@ -214,37 +286,45 @@ BGL_API void bgl_clear_index_buffers(bgl_instance bgl) {
 }
 
 BGL_API void bgl_draw_index_buffers(bgl_instance bgl, bgl_drawing_modes mode) {
-    mat4 vp;
-    vec4 camera, light;
-    vertex_item *vhb_buf, *vertices;
-
-    prepare_buffers(bgl, camera, light, vp, &vhb_buf);
-
-    for (bgl_index_buffer buf = bgl->index_buffer; buf; buf = buf->next) {
-        bgl_drawing_modes true_mode = mode ? : buf->render_mode;
-        vertices = &vhb_buf[buf->vbuf->vitem_off];
-
-        switch (true_mode) {
-        case BGL_POINTS:
-            draw_points(bgl, buf, vertices);
-            break;
-        case BGL_LINES:
-        case BGL_LINES_STRIP:
-        case BGL_LINES_LOOP:
-            draw_lines(bgl, buf, vertices, true_mode);
-            break;
-        case BGL_TRIANGLES:
-        case BGL_TRIANGLES_STRIP:
-            draw_triangles(bgl, buf, vertices, camera, light, true_mode);
-            break;
-        case BGL_TRIANGLES_FAN:
-            draw_triangles_fan(bgl, buf, vertices, camera, light);
-            break;
-        default:
-            fprintf(stderr, "Invalid drawing mode: 0x%04X\n", true_mode);
-            break;
-        }
+    int in_frame = bgl->frame.active;
+
+    if (!in_frame)
+        bgl_begin_frame(bgl);
+
+    for (bgl_index_buffer buf = bgl->index_buffer; buf; buf = buf->next)
+        if (!buf->lod || buf->lod->selected == buf)
+            draw_index_buf(bgl, buf, 0, buf->count, mode);
+
+    if (!in_frame)
+        bgl_end_frame(bgl);
+}
+
+BGL_API int bgl_draw_index_buffer_range(bgl_instance bgl, int ibuf_id, int first, int count, bgl_drawing_modes mode) {
+    bgl_index_buffer buf = bgl->index_buffer;
+    int in_frame = bgl->frame.active;
+
+    for (; buf && buf->id != ibuf_id; buf = buf->next);
+    if (!buf) {
+        fprintf(stderr, "bgl_draw_index_buffer_range: Invalid index buffer ID: %i\n", ibuf_id);
+        return false;
+    }
+
+    if (first < 0 || count < 0 || first > buf->count) {
+        fprintf(stderr, "bgl_draw_index_buffer_range: Invalid range: %i, %i\n", first, count);
+        return false;
     }
+    if (count > buf->count - first)
+        count = buf->count - first;
+
+    if (!in_frame)
+        bgl_begin_frame(bgl);
+
+    // an explicit draw bypasses LOD selection
+    if (count)
+        draw_index_buf(bgl, buf, first, count, mode);
+
+    if (!in_frame)
+        bgl_end_frame(bgl);
 
-    draw_buffers(bgl, vp);
+    return true;
 }
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal.h"
+
+
+#define LOD_DEFAULT_THRESHOLD 1.0f
+
+static void insert_lod(bgl_instance bgl, bgl_lod lod) {
+    lod->next = bgl->lod;
+    bgl->lod = lod;
+    ++bgl->lod_cnt;
+}
+
+static void free_lod(bgl_instance bgl, bgl_lod lod, int with_ibufs) {
+    for (int i = 0; i < lod->level_cnt; ++i) {
+        if (!lod->levels[i])
+            continue;
+        lod->levels[i]->lod = NULL;
+        if (with_ibufs)
+            bgl_remove_index_buffer(bgl, lod->levels[i]->id, false);
+    }
+    free(lod->levels);
+    free(lod->errors);
+    free(lod);
+}
+
+static bgl_lod get_lod(bgl_instance bgl, int id) {
+    bgl_lod l = bgl->lod;
+
+    while (l && l->id != id)
+        l = l->next;
+
+    return l;
+}
+
+void detach_lod_level(bgl_index_buffer ibuf) {
+    bgl_lod lod = ibuf->lod;
+
+    for (int i = 0; i < lod->level_cnt; ++i)
+        if (lod->levels[i] == ibuf)
+            lod->levels[i] = NULL;
+    if (lod->selected == ibuf)
+        lod->selected = NULL;
+    ibuf->lod = NULL;
+}
+
+/*!
+ * @brief Pick the coarsest level whose error projects below the threshold.
+ * The error is scaled by the distance to the nearest point of the bounding sphere.
+ */
+void select_lods(bgl_instance bgl, vec4 camera) {
+    for (bgl_lod lod = bgl->lod; lod; lod = lod->next) {
+        int level = 0;
+
+        while (level < lod->level_cnt - 1 && !lod->levels[level])
+            ++level;
+        lod->selected = lod->levels[level];
+        if (!lod->selected)
+            continue;
+
+        float px = vertex_buf_pixel_scale(bgl, lod->selected->vbuf, camera);
+        if (px < 0)
+            continue;
+
+        for (int i = lod->level_cnt; --i > level;) {
+            if (lod->levels[i] && lod->errors[i] * px <= lod->threshold) {
+                lod->selected = lod->levels[i];
+                break;
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BGL_API int bgl_create_lod(bgl_instance bgl, const int *ibuf_ids, const float *errors, int count) {
+    static int new_id = 0;
+
+    if (new_id == INT_MIN) {
+        fprintf(stderr, "Failed to create LOD: LOD limit reached\n");
+        return -1;
+    }
+
+    if (count < 1) {
+        fprintf(stderr, "Failed to create LOD: no levels\n");
+        return -1;
+    }
+
+    bgl_lod lod = calloc(1, sizeof(*lod));
+    if (!(lod && (lod->levels = malloc(count * sizeof(*lod->levels)))
+              && (lod->errors = malloc(count * sizeof(*lod->errors))))) {
+        fprintf(stderr, "Failed to create LOD: %s\n", strerror(errno));
+        if (lod)
+            free(lod->levels);
+        free(lod);
+        return -1;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        bgl_index_buffer b = bgl->index_buffer;
+
+        while (b && b->id != ibuf_ids[i])
+            b = b->next;
+
+        if (!b || b->lod || (i && b->vbuf != lod->levels[0]->vbuf)) {
+            fprintf(stderr, "Failed to create LOD: invalid index buffer ID: %i\n", ibuf_ids[i]);
+            lod->level_cnt = i;
+            free_lod(bgl, lod, false);
+            return -1;
+        }
+
+        lod->levels[i] = b;
+        lod->errors[i] = errors[i];
+        b->lod = lod;
+    }
+
+    lod->level_cnt = count;
+    lod->id = new_id++;
+    lod->threshold = LOD_DEFAULT_THRESHOLD;
+
+    insert_lod(bgl, lod);
+
+    return lod->id;
+}
+
+BGL_API void bgl_remove_lod(bgl_instance bgl, int lod_id, int with_ibufs) {
+    bgl_lod *l = &bgl->lod;
+
+    while (*l) {
+        if ((*l)->id == lod_id) {
+            bgl_lod lod = *l;
+            *l = lod->next;
+            --bgl->lod_cnt;
+            free_lod(bgl, lod, with_ibufs);
+            return;
+        }
+        l = &(*l)->next;
+    }
+}
+
+BGL_API void bgl_clear_lods(bgl_instance bgl) {
+    bgl_lod l = bgl->lod;
+
+    while (l) {
+        bgl_lod next = l->next;
+        free_lod(bgl, l, false);
+        l = next;
+    }
+    bgl->lod = NULL;
+    bgl->lod_cnt = 0;
+}
+
+BGL_API int bgl_set_lod_threshold(bgl_instance bgl, int lod_id, float pixels) {
+    bgl_lod lod = get_lod(bgl, lod_id);
+
+    if (!lod) {
+        fprintf(stderr, "bgl_set_lod_threshold: Invalid LOD ID: %i\n", lod_id);
+        return false;
+    }
+
+    lod->threshold = pixels;
+
+    return true;
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <errno.h>
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal.h"
+
+
+#define MESHLET_MIN_TRIS 16
+#define MESHLET_MAX_TRIS 256
+#define MESHLET_CONE_LIMIT 0.7f  // min cos between a triangle and the meshlet normals
+
+static void meshlet_bounds(meshlet *m, vec4 *positions, const vindex *indices) {
+    vec3 min = {FLT_MAX, FLT_MAX, FLT_MAX}, max = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    vec3 axis = GLM_VEC3_ZERO_INIT, n;
+    float radius = 0, min_dp = 1;
+
+    for (int i = m->first; i < m->first + m->count; ++i) {
+        glm_vec3_minv(min, positions[indices[i].idx], min);
+        glm_vec3_maxv(max, positions[indices[i].idx], max);
+    }
+    glm_vec3_center(min, max, m->sphere);
+    for (int i = m->first; i < m->first + m->count; ++i)
+        radius = glm_max(radius, glm_vec3_distance(m->sphere, positions[indices[i].idx]));
+    m->sphere[3] = radius;
+
+    // same normals as the per triangle back-face test
+    for (int i = m->first; i < m->first + m->count; i += 3) {
+        triangle_normal(positions[indices[i].idx],
+                        positions[indices[i + 1].idx],
+                        positions[indices[i + 2].idx],
+                        n);
+        glm_vec3_add(axis, n, axis);
+    }
+    glm_vec3_normalize(axis);
+
+    for (int i = m->first; i < m->first + m->count; i += 3) {
+        triangle_normal(positions[indices[i].idx],
+                        positions[indices[i + 1].idx],
+                        positions[indices[i + 2].idx],
+                        n);
+        if (glm_vec3_norm2(n) > 0)
+            min_dp = glm_min(min_dp, glm_vec3_dot(axis, n));
+    }
+
+    glm_vec3_copy(axis, m->cone);
+
+    // cone spread widened by 90 degrees: cos(a + 90) = -sin(a); 1 disables the test
+    m->cone[3] = min_dp <= 0.1f ? 1.0f : sqrtf(1.0f - min_dp * min_dp);
+}
+
+/*!
+ * @brief Check a meshlet against the frustum and the camera.
+ * Bounds are transformed with the model matrix; the cone test assumes uniform scale.
+ */
+int meshlet_visible(const meshlet *m, mat4 model, float scale, vec4 planes[6], vec4 camera, int cone_cull) {
+    vec4 center;
+    vec3 axis, dir;
+    float radius = m->sphere[3] * scale;
+
+    glm_vec4((float *)m->sphere, 1.0f, center);
+    glm_mat4_mulv(model, center, center);
+
+    for (int i = 0; i < 6; ++i)
+        if (glm_vec3_dot(planes[i], center) + planes[i][3] < -radius)
+            return false;
+
+    if (!cone_cull || m->cone[3] >= 1.0f)
+        return true;
+
+    glm_mat4_mulv3(model, (float *)m->cone, 0.0f, axis);
+    glm_vec3_normalize(axis);
+    glm_vec3_sub(center, camera, dir);
+
+    return glm_vec3_dot(dir, axis) < m->cone[3] * glm_vec3_norm(dir) + radius;
+}
+
+float model_max_scale(mat4 model) {
+    float s = glm_max(glm_vec3_norm2(model[0]), glm_max(glm_vec3_norm2(model[1]), glm_vec3_norm2(model[2])));
+    return sqrtf(s);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BGL_API int bgl_build_index_buffer_meshlets(bgl_instance bgl, int ibuf_id, int max_tris) {
+    bgl_index_buffer buf = bgl->index_buffer;
+    int v_cnt, t_cnt, cnt = 0;
+
+    for (; buf && buf->id != ibuf_id; buf = buf->next);
+    if (!buf) {
+        fprintf(stderr, "bgl_build_index_buffer_meshlets: Invalid index buffer ID: %i\n", ibuf_id);
+        return -1;
+    }
+    if (buf->render_mode != BGL_TRIANGLES) {
+        fprintf(stderr, "bgl_build_index_buffer_meshlets: Meshlets need a triangle list, got mode 0x%04X\n",
+                buf->render_mode);
+        return -1;
+    }
+
+    if (max_tris < MESHLET_MIN_TRIS)
+        max_tris = MESHLET_MIN_TRIS;
+    else if (max_tris > MESHLET_MAX_TRIS)
+        max_tris = MESHLET_MAX_TRIS;
+
+    v_cnt = buf->vbuf->count;
+    t_cnt = buf->count / 3;
+    for (int i = 0; i < t_cnt * 3; ++i) {
+        if (buf->indices[i].idx < 0 || buf->indices[i].idx >= v_cnt) {
+            fprintf(stderr, "bgl_build_index_buffer_meshlets: Invalid vertex index: %i\n", buf->indices[i].idx);
+            return -1;
+        }
+    }
+
+    int *offsets = calloc(v_cnt + 1, sizeof(*offsets));
+    int *adjacency = malloc((t_cnt * 3 + 1) * sizeof(*adjacency));
+    int *marks = malloc((v_cnt + 1) * sizeof(*marks));
+    int *mverts = malloc(max_tris * sizeof(*mverts));
+    char *emitted = calloc(t_cnt + 1, sizeof(*emitted));
+    vec3 *normals = malloc((t_cnt + 1) * sizeof(*normals));
+    vindex *out = malloc((t_cnt * 3 + 1) * sizeof(*out));
+    meshlet *meshlets = malloc((t_cnt + 1) * sizeof(*meshlets));
+    vec4 *positions = bgl_aligned_alloc(16, (v_cnt + 1) * sizeof(*positions));
+
+    if (!(offsets && adjacency && marks && mverts && emitted && normals && out && meshlets && positions)) {
+        fprintf(stderr, "Failed to build meshlets: %s\n", strerror(errno));
+        cnt = -1;
+        goto end;
+    }
+
+    for (int v = 0; v < v_cnt; ++v)
+        vertex_buf_position(buf->vbuf, v, positions[v]);
+
+    for (int i = 0; i < t_cnt * 3; ++i)
+        ++offsets[buf->indices[i].idx + 1];
+    for (int v = 0; v < v_cnt; ++v)
+        offsets[v + 1] += offsets[v];
+    memcpy(marks, offsets, v_cnt * sizeof(*marks));
+    for (int i = 0; i < t_cnt * 3; ++i)
+        adjacency[marks[buf->indices[i].idx]++] = i / 3;
+    memset(marks, 0xFF, v_cnt * sizeof(*marks));
+
+    for (int t = 0; t < t_cnt; ++t)
+        triangle_normal(positions[buf->indices[t * 3].idx],
+                        positions[buf->indices[t * 3 + 1].idx],
+                        positions[buf->indices[t * 3 + 2].idx],
+                        normals[t]);
+
+    /*
+     * Grow each meshlet over shared vertices, preferring triangles that add no
+     * vertices and face the same way, so the normal cones stay narrow.
+     */
+    vec3 cone = GLM_VEC3_ZERO_INIT, axis;
+    int tris = 0, verts = 0, cursor = 0;
+
+    for (int emitted_cnt = 0; emitted_cnt < t_cnt; ++emitted_cnt) {
+        int best = -1;
+
+        if (tris < max_tris) {
+            float best_score = FLT_MAX;
+
+            glm_vec3_normalize_to(cone, axis);
+            for (int j = 0; j < verts; ++j) {
+                for (int *adj = &adjacency[offsets[mverts[j]]]; adj < &adjacency[offsets[mverts[j] + 1]]; ++adj) {
+                    if (emitted[*adj])
+                        continue;
+
+                    int extra = 0;
+                    for (int k = 0; k < 3; ++k)
+                        extra += marks[buf->indices[*adj * 3 + k].idx] != cnt;
+
+                    float dp = glm_vec3_dot(axis, normals[*adj]);
+                    if (verts + extra > max_tris || dp < MESHLET_CONE_LIMIT)
+                        continue;
+
+                    float score = (float)extra + 2.0f * (1.0f - dp);
+                    if (score < best_score) {
+                        best_score = score;
+                        best = *adj;
+                    }
+                }
+            }
+        }
+
+        if (best < 0) {
+            if (tris) {
+                meshlet_bounds(&meshlets[cnt++], positions, out);
+                glm_vec3_zero(cone);
+                tris = verts = 0;
+            }
+            while (emitted[cursor])
+                ++cursor;
+            best = cursor;
+            meshlets[cnt].first = emitted_cnt * 3;
+            meshlets[cnt].count = 0;
+        }
+
+        for (int k = 0; k < 3; ++k) {
+            int v = buf->indices[best * 3 + k].idx;
+            if (marks[v] != cnt) {
+                marks[v] = cnt;
+                mverts[verts++] = v;
+            }
+        }
+        memcpy(&out[emitted_cnt * 3], &buf->indices[best * 3], 3 * sizeof(*out));
+        glm_vec3_add(cone, normals[best], cone);
+        emitted[best] = 1;
+        meshlets[cnt].count += 3;
+        ++tris;
+    }
+    if (tris)
+        meshlet_bounds(&meshlets[cnt++], positions, out);
+
+    // triangles are depth sorted later, so meshlet order costs nothing
+    memcpy(buf->indices, out, t_cnt * 3 * sizeof(*out));
+    free(buf->meshlets);
+    buf->meshlets = meshlets;
+    buf->meshlet_cnt = cnt;
+    meshlets = NULL;
+
+end:
+    free(offsets);
+    free(adjacency);
+    free(marks);
+    free(mverts);
+    free(emitted);
+    free(normals);
+    free(out);
+    free(meshlets);
+    bgl_aligned_free(positions);
+
+    return cnt;
+}
@@ -9,6 +9,8 @@
 # define _GNU_SOURCE
 #endif
 
+#include <stdio.h>
+
 #include "internal.h"
 
 
@@ -51,20 +53,43 @@ void triangle_normal(vec3 a, vec3 b, vec3 c, vec3 dst) {
     glm_vec3_crossn(u, v, dst);
 }
 
-idx_item *push_back_helper_buf_idx(bgl_instance bgl, int v_off, ivec3 idxs, vec4 color, int n) {
+/*!
+ * @brief Lambert term; faces that stay visible under the cull mode are lit from either side.
+ */
+float face_light(vec3 norm, vec4 light, int cull_mode) {
+    float d = glm_vec3_dot(norm, light);
+
+    switch (cull_mode) {
+    case BGL_CULL_BACK:
+        return glm_max(d, 0);
+    case BGL_CULL_FRONT:
+        return glm_max(-d, 0);
+    default:
+        return fabsf(d);
+    }
+}
+
+idx_item *push_back_helper_buf_idx(bgl_instance bgl, int v_off, ivec3 idxs, const vec4 color, int n, int cull_mode) {
     IHB_INIT(bgl, ihb);
-    VHB_INIT(bgl, vhb);
+    void *tmp;
 
-    if ((ihb->cnt >= ihb->buf_sz || !ihb->buf)
-            && !(ihb->buf = realloc(ihb->buf, (ihb->buf_sz <<= 1) * sizeof(idx_item))))
-        return NULL;
+    if ((ihb->cnt >= ihb->buf_sz || !ihb->buf)) {
+        if (!(tmp = realloc(ihb->buf, (ihb->buf_sz << 1) * sizeof(idx_item))))
+            return NULL;
+        ihb->buf = tmp;
+        ihb->buf_sz <<= 1;
+    }
 
     idx_item *ibuf = (idx_item *)ihb->buf + ihb->cnt++;
 
-    glm_ivec3_copy(idxs, ibuf->tri);
-    glm_vec4_copy(color, ibuf->color);
-    ibuf->n = n;
-    ibuf->v_off = v_off;
+    ibuf->tri[1] = ibuf->tri[2] = 0;
+    for (int k = 0; k < n; ++k)
+        ibuf->tri[k] = (uint32_t)(v_off + idxs[k]);
+    ibuf->tri[0] |= (uint32_t)n << IDX_ITEM_PRIM_SHIFT;
+    ibuf->tri[1] |= (uint32_t)cull_mode << IDX_ITEM_CULL_SHIFT;
+
+    // converted once here instead of once per raster call
+    ibuf->color = bgl_vec4_to_argb(color);
     ibuf->avg_z = NAN;
 
     return ibuf;
@@ -72,10 +97,14 @@ idx_item *push_back_helper_buf_idx(bgl_instance bgl, int v_off, ivec3 idxs, vec4
 
 static int push_back_helper_buf_vtx(bgl_instance bgl, vec4 v) {
     VHB_INIT(bgl, vhb);
+    void *tmp;
 
-    if ((vhb->cnt >= vhb->buf_sz || !vhb->buf)
-            && !(vhb->buf = realloc(vhb->buf, (vhb->buf_sz <<= 1) * sizeof(vertex_item))))
-        return -1;
+    if ((vhb->cnt >= vhb->buf_sz || !vhb->buf)) {
+        if (!(tmp = realloc(vhb->buf, (vhb->buf_sz << 1) * sizeof(vertex_item))))
+            return -1;
+        vhb->buf = tmp;
+        vhb->buf_sz <<= 1;
+    }
 
     vertex_item *vbuf = (vertex_item *)vhb->buf + vhb->cnt;
 
@@ -142,7 +171,9 @@ void prepare_buffers(bgl_instance bgl, vec4 camera, vec4 light, mat4 vp, vertex_
         vbuf->vitem_off = vhb->cnt;
         vhb->cnt = new_sz;
 
-        if (*model)
+        if (vbuf->packed)
+            transform_packed_vertices(vbuf, *model ? model : NULL, vitem);
+        else if (*model)
             for (int j = 0; j < vbuf->count; ++j) {
                 glm_mat4_mulv(*model, vbuf->vertices[j].pos, vitem[j].vtx);
                 vitem[j].used = 0;
@@ -181,6 +212,97 @@ static void vec_intersect_plane(clip_plane *plane, vec3 a, vec3 b, vec3 dst) {
     glm_vec3_add(a, dst, dst);
 }
 
+static int area_culled(int mode, const float *a, const float *b, const float *c) {
+    float area = (b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1]);
+
+    return mode == BGL_CULL_BACK ? area < 0 : mode == BGL_CULL_FRONT && area > 0;
+}
+
+/*!
+ * @brief Face culling by the sign of the NDC area, front faces being counter-clockwise.
+ * Triangles reaching behind the eye have no meaningful NDC area, they are tested after clipping.
+ */
+static int tri_culled(vertex_item *vertices, idx_item *ibuf) {
+    int mode = IDX_ITEM_CULL(ibuf);
+    float *a, *b, *c;
+
+    if (mode == BGL_CULL_NONE)
+        return false;
+
+    a = vertices[IDX_ITEM_IDX(ibuf, 0)].vtx;
+    b = vertices[IDX_ITEM_IDX(ibuf, 1)].vtx;
+    c = vertices[IDX_ITEM_IDX(ibuf, 2)].vtx;
+    if (!(a[3] > 0 && b[3] > 0 && c[3] > 0))
+        return false;
+
+    return area_culled(mode, a, b, c);
+}
+
+/*!
+ * @brief Post-projection test for triangles that cannot cover a pixel center.
+ * Only triangles between the near and far planes are tested; the others are
+ * not meaningful in NDC until clipped.
+ */
+static int tri_misses_pixels(bgl_viewport_internal *viewport, vertex_item *vertices, idx_item *ibuf) {
+    vec3 p[3];
+
+    for (int k = 0; k < 3; ++k) {
+        float *v = vertices[IDX_ITEM_IDX(ibuf, k)].vtx;
+        if (!(v[3] > 0 && v[2] >= -1 && v[2] <= 1))
+            return false;
+        dev_to_fb(viewport, v, p[k]);
+    }
+
+    float area = (p[1][0] - p[0][0]) * (p[2][1] - p[0][1]) - (p[2][0] - p[0][0]) * (p[1][1] - p[0][1]);
+    if (area == 0)
+        return true;
+
+    float min_x = glm_min(p[0][0], glm_min(p[1][0], p[2][0])), max_x = glm_max(p[0][0], glm_max(p[1][0], p[2][0]));
+    float min_y = glm_min(p[0][1], glm_min(p[1][1], p[2][1])), max_y = glm_max(p[0][1], glm_max(p[1][1], p[2][1]));
+
+    // no pixel center between the bounds on one of the axes
+    return roundf(min_x) == roundf(max_x) || roundf(min_y) == roundf(max_y);
+}
+
+/*!
+ * @brief Pixels per model unit at the nearest point of the vertex buffer bounds.
+ * Returns a negative value without a projection or with the camera inside the bounds.
+ */
+float vertex_buf_pixel_scale(bgl_instance bgl, bgl_vertex_buffer vbuf, vec4 camera) {
+    mat4 *model = vbuf->model_m ? : bgl->glob_uniform.model;
+    mat4 identity = GLM_MAT4_IDENTITY_INIT;
+    vec4 center;
+
+    if (!bgl->glob_uniform.proj)
+        return -1.0f;
+    if (!model)
+        model = &identity;
+
+    float scale = model_max_scale(*model);
+    glm_vec4(vbuf->sphere, 1.0f, center);
+    glm_mat4_mulv(*model, center, center);
+
+    float dist = glm_vec3_distance(center, camera) - vbuf->sphere[3] * scale;
+    if (dist <= FLT_EPSILON)
+        return -1.0f;
+
+    return (*bgl->glob_uniform.proj)[1][1] * fabsf(bgl->viewport.pyh) * scale / dist;
+}
+
+/*!
+ * @brief Push the intersection of edge ab with the plane as a new helper vertex.
+ * The helper buffer may move, so callers reload their vertex pointer afterwards.
+ */
+static int clip_edge(bgl_instance bgl, clip_plane *plane, int a, int b) {
+    VHB_INIT(bgl, vhb);
+    vertex_item *vertices = vhb->buf;
+    vec4 vt = {0, 0, 0, 1};
+
+    vec_intersect_plane(plane, vertices[a].vtx, vertices[b].vtx, vt);
+
+    return push_back_helper_buf_vtx(bgl, vt);
+}
+
 static void clip_tri(bgl_instance bgl, idx_item *ibuf, ivec3 out[64], ivec3 **start, ivec3 **end) {
     static const clip_plane clip_planes[] = {
             {{0, 0, -1}, {0, 0, 1}, -1},    // near Z
@@ -194,17 +316,19 @@ static void clip_tri(bgl_instance bgl, idx_item *ibuf, ivec3 out[64], ivec3 **st
     VHB_INIT(bgl, vhb);
 
     ivec3 *to_clipped_hd = out, *to_clipped_tail = out, *t;
-    vec4 vt;
 
     float d0, d1, d2;
     int insides[3], outsides[3];
-    int inside_cnt, outside_cnt;
-    vertex_item *vertices = &((vertex_item *)vhb->buf)[ibuf->v_off];
+    int inside_cnt, outside_cnt, tmp;
+    vertex_item *vertices;
 
-    glm_ivec3_copy(ibuf->tri, *to_clipped_tail++);
+    (*to_clipped_tail)[0] = (int)(ibuf->tri[0] & IDX_ITEM_IDX_MASK);
+    (*to_clipped_tail)[1] = (int)(ibuf->tri[1] & IDX_ITEM_IDX_MASK);
+    (*to_clipped_tail++)[2] = (int)ibuf->tri[2];
 
     for (clip_plane *plane = (clip_plane *)clip_planes; plane < &clip_planes[sizeof(clip_planes) / sizeof(*clip_planes)]; ++plane) {
         for (t = to_clipped_tail; to_clipped_hd < t; ++to_clipped_hd) {
+            vertices = vhb->buf;
             inside_cnt = outside_cnt = 0;
             d0 = glm_vec3_dot(plane->norm, vertices[(*to_clipped_hd)[0]].vtx) - plane->d;
             d1 = glm_vec3_dot(plane->norm, vertices[(*to_clipped_hd)[1]].vtx) - plane->d;
@@ -240,28 +364,41 @@ static void clip_tri(bgl_instance bgl, idx_item *ibuf, ivec3 out[64], ivec3 **st
             case 1: // outside_cnt == 2
                 vertices[outsides[0]].used = vertices[outsides[1]].used = 0;
 
-                (*to_clipped_tail)[0] = insides[0];
-
-                vec_intersect_plane(plane, vertices[insides[0]].vtx, vertices[outsides[0]].vtx, vt);
-                (*to_clipped_tail)[1] = push_back_helper_buf_vtx(bgl, vt) - ibuf->v_off;
+                // keep the winding of the source tri for face culling
+                if (d1 >= 0) {
+                    tmp = outsides[0];
+                    outsides[0] = outsides[1];
+                    outsides[1] = tmp;
+                }
 
-                vec_intersect_plane(plane, vertices[insides[0]].vtx, vertices[outsides[1]].vtx, vt);
-                (*to_clipped_tail++)[2] = push_back_helper_buf_vtx(bgl, vt) - ibuf->v_off;
+                (*to_clipped_tail)[0] = insides[0];
+                (*to_clipped_tail)[1] = clip_edge(bgl, plane, insides[0], outsides[0]);
+                (*to_clipped_tail)[2] = clip_edge(bgl, plane, insides[0], outsides[1]);
+                if ((*to_clipped_tail)[1] < 0 || (*to_clipped_tail)[2] < 0)
+                    goto fail;
+                ++to_clipped_tail;
 
                 break;  // 1 new tri
 
             case 2: // outside_cnt == 1
                 vertices[outsides[0]].used = 0;
 
+                // keep the winding of the source tri for face culling
+                if (d1 < 0) {
+                    tmp = insides[0];
+                    insides[0] = insides[1];
+                    insides[1] = tmp;
+                }
+
                 (*to_clipped_tail)[0] = insides[0];
                 (*to_clipped_tail)[1] = insides[1];
-                vec_intersect_plane(plane, vertices[insides[0]].vtx, vertices[outsides[0]].vtx, vt);
-                (*to_clipped_tail++)[2] = push_back_helper_buf_vtx(bgl, vt) - ibuf->v_off;
+                if (((*to_clipped_tail++)[2] = clip_edge(bgl, plane, insides[1], outsides[0])) < 0)
+                    goto fail;
 
-                (*to_clipped_tail)[0] = insides[1];
+                (*to_clipped_tail)[0] = insides[0];
                 (*to_clipped_tail)[1] = to_clipped_tail[-1][2];
-                vec_intersect_plane(plane, vertices[insides[1]].vtx, vertices[outsides[0]].vtx, vt);
-                (*to_clipped_tail++)[2] = push_back_helper_buf_vtx(bgl, vt) - ibuf->v_off;
+                if (((*to_clipped_tail++)[2] = clip_edge(bgl, plane, insides[0], outsides[0])) < 0)
+                    goto fail;
 
                 break;  // 2 new tri
 
@@ -277,6 +414,10 @@ static void clip_tri(bgl_instance bgl, idx_item *ibuf, ivec3 out[64], ivec3 **st
 
     *start = to_clipped_hd;
     *end = to_clipped_tail;
+    return;
+
+fail:
+    *start = *end = out;
 }
 
 void draw_buffers(bgl_instance bgl, mat4 vp) {
@@ -286,28 +427,36 @@ void draw_buffers(bgl_instance bgl, mat4 vp) {
     idx_item *cbuf = chb->buf;
     ivec3 clipped[64], *clip, *clipped_end;
     vertex_item *vertices;
+    void *tmp;
 
-    if ((chb->buf_sz < ihb->buf_sz || !cbuf)
-            && !(cbuf = chb->buf = realloc(cbuf, (chb->buf_sz = ihb->buf_sz) * sizeof(*cbuf))))
-        return;
+    if (chb->buf_sz < ihb->buf_sz || !cbuf) {
+        if (!(tmp = realloc(cbuf, ihb->buf_sz * sizeof(*cbuf))))
+            return;
+        cbuf = chb->buf = tmp;
+        chb->buf_sz = ihb->buf_sz;
+    }
 
-    // transform to view then project space
-    for (vertex_item *vxi = vhb->buf; vxi < &((vertex_item *)vhb->buf)[vhb->cnt]; ++vxi)
-        if (vxi->used)
-            loc_to_dev(vp, vxi->vtx, vxi->vtx);
+    // transform to view then project space, keeping clip w for the face tests
+    for (vertex_item *vxi = vhb->buf; vxi < &((vertex_item *)vhb->buf)[vhb->cnt]; ++vxi) {
+        if (vxi->used) {
+            vec4 t;
+            glm_mat4_mulv(vp, vxi->vtx, t);
+            glm_vec3_divs(t, t[3] < FLT_MIN ? FLT_MIN : t[3], vxi->vtx);
+            vxi->vtx[3] = t[3];
+        }
+    }
 
     int i = ihb->cnt;
     for (idx_item *ibuf = ihb->buf; i--; ++ibuf) {
-        vertices = &((vertex_item *)vhb->buf)[ibuf->v_off];
-
-        switch (ibuf->n) {
+        switch (IDX_ITEM_PRIM(ibuf)) {
         case 1:
             {
-                vec4 *p = &vertices[ibuf->tri[0]].vtx;
+                vertices = vhb->buf;
+                vec4 *p = &vertices[IDX_ITEM_IDX(ibuf, 0)].vtx;
                 if ((*p)[0] >= -1 && (*p)[0] <= 1
                         && (*p)[1] >= -1 && (*p)[1] <= 1
                         && (*p)[2] >= -1 && (*p)[2] <= 1) {
-                    ibuf->avg_z = vertices[ibuf->tri[0]].vtx[2];
+                    ibuf->avg_z = (*p)[2];
                     cbuf[chb->cnt++] = *ibuf;
                 }
             }
@@ -318,16 +467,32 @@ void draw_buffers(bgl_instance bgl, mat4 vp) {
             break;
 
         case 3:
+            if (tri_culled(vhb->buf, ibuf) || tri_misses_pixels(&bgl->viewport, vhb->buf, ibuf))
+                break;
+
             clip_tri(bgl, ibuf, clipped, &clip, &clipped_end);
             if (clip != clipped_end) {
-                if (chb->cnt + (clipped_end - clip) >= chb->buf_sz
-                        && !(cbuf = chb->buf = realloc(cbuf, (chb->buf_sz <<= 1) * sizeof(*cbuf))))
-                    return;
+                if (chb->cnt + (clipped_end - clip) >= chb->buf_sz) {
+                    if (!(tmp = realloc(cbuf, (chb->buf_sz << 1) * sizeof(*cbuf))))
+                        return;
+                    cbuf = chb->buf = tmp;
+                    chb->buf_sz <<= 1;
+                }
 
+                // clipping may have moved the helper vertices
+                vertices = vhb->buf;
                 for (; clip < clipped_end; ++clip) {
-                    cbuf[chb->cnt] = *ibuf;
-                    glm_ivec3_copy(*clip, cbuf[chb->cnt].tri);
-                    cbuf[chb->cnt++].avg_z = (vertices[(*clip)[0]].vtx[2] + vertices[(*clip)[1]].vtx[2] + vertices[(*clip)[2]].vtx[2]) / 3.0f;
+                    // the parts of a tri crossing the near plane get their face test here
+                    if (area_culled(IDX_ITEM_CULL(ibuf), vertices[(*clip)[0]].vtx,
+                                    vertices[(*clip)[1]].vtx, vertices[(*clip)[2]].vtx))
+                        continue;
+
+                    idx_item *c = &cbuf[chb->cnt++];
+                    c->tri[0] = (uint32_t)(*clip)[0] | 3u << IDX_ITEM_PRIM_SHIFT;
+                    c->tri[1] = (uint32_t)(*clip)[1] | (uint32_t)IDX_ITEM_CULL(ibuf) << IDX_ITEM_CULL_SHIFT;
+                    c->tri[2] = (uint32_t)(*clip)[2];
+                    c->color = ibuf->color;
+                    c->avg_z = (vertices[(*clip)[0]].vtx[2] + vertices[(*clip)[1]].vtx[2] + vertices[(*clip)[2]].vtx[2]) / 3.0f;
                     vertices[(*clip)[0]].used = vertices[(*clip)[1]].used = vertices[(*clip)[2]].used = 1;
                 }
             }
@@ -346,34 +511,33 @@ void draw_buffers(bgl_instance bgl, mat4 vp) {
 //            dev_to_fb(&bgl->viewport, vxi->vtx, vxi->vtx);
             dev_to_fbi(&bgl->viewport, vxi->vtx, vxi->ivtx);
 
-//    vec4 wires = GLM_VEC4_ONE_INIT;
+//    uint32_t wires = 0xFFFFFFFF;
 
+    vertices = vhb->buf;
     i = chb->cnt;
     for (; i--; ++cbuf) {
-        vertices = &((vertex_item *)vhb->buf)[cbuf->v_off];
-
-        switch (cbuf->n) {
+        switch (IDX_ITEM_PRIM(cbuf)) {
         case 1:
-            bgl->dev.draw_pixel(bgl, vertices[cbuf->tri[0]].ivtx, cbuf->color);
+            bgl->dev.draw_pixel(bgl, vertices[IDX_ITEM_IDX(cbuf, 0)].ivtx, cbuf->color);
             break;
         case 2:
             bgl->dev.draw_line(bgl,
-                               vertices[cbuf->tri[0]].ivtx,
-                               vertices[cbuf->tri[1]].ivtx,
+                               vertices[IDX_ITEM_IDX(cbuf, 0)].ivtx,
+                               vertices[IDX_ITEM_IDX(cbuf, 1)].ivtx,
                                cbuf->color);
             break;
         case 3:
             bgl->dev.draw_fill_triangle(bgl,
-                                        vertices[cbuf->tri[0]].ivtx,
-                                        vertices[cbuf->tri[1]].ivtx,
-                                        vertices[cbuf->tri[2]].ivtx,
+                                        vertices[IDX_ITEM_IDX(cbuf, 0)].ivtx,
+                                        vertices[IDX_ITEM_IDX(cbuf, 1)].ivtx,
+                                        vertices[IDX_ITEM_IDX(cbuf, 2)].ivtx,
                                         cbuf->color);
 
             /*  TODO: set drawing mode (points, lines (wireframes), fill)
             bgl->dev.draw_triangle(bgl,
-                                   vertices[cbuf->tri[0]].ivtx,
-                                   vertices[cbuf->tri[1]].ivtx,
-                                   vertices[cbuf->tri[2]].ivtx,
+                                   vertices[IDX_ITEM_IDX(cbuf, 0)].ivtx,
+                                   vertices[IDX_ITEM_IDX(cbuf, 1)].ivtx,
+                                   vertices[IDX_ITEM_IDX(cbuf, 2)].ivtx,
                                    wires);
             //*/
             break;
@@ -382,3 +546,28 @@ void draw_buffers(bgl_instance bgl, mat4 vp) {
 
     ihb->cnt = vhb->cnt = chb->cnt = 0;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+BGL_API void bgl_begin_frame(bgl_instance bgl) {
+    if (bgl->frame.active) {
+        fprintf(stderr, "bgl_begin_frame: Frame already begun\n");
+        return;
+    }
+
+    // vertex buffers are transformed once, however many draws follow
+    prepare_buffers(bgl, bgl->frame.camera, bgl->frame.light, bgl->frame.vp, &bgl->frame.vertices);
+    glm_frustum_planes(bgl->frame.vp, bgl->frame.planes);
+    select_lods(bgl, bgl->frame.camera);
+    bgl->frame.active = true;
+}
+
+BGL_API void bgl_end_frame(bgl_instance bgl) {
+    if (!bgl->frame.active) {
+        fprintf(stderr, "bgl_end_frame: Frame not begun\n");
+        return;
+    }
+
+    bgl->frame.active = false;
+    draw_buffers(bgl, bgl->frame.vp);
+}
@@ -6,6 +6,7 @@
  */
 
 #include <errno.h>
+#include <float.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -14,6 +15,8 @@
 #include "internal.h"
 
 
+static int new_id = 0;
+
 static void insert_vertex_buf(bgl_instance bgl, bgl_vertex_buffer vbuf) {
     vbuf->next = bgl->vertex_buffer;
     bgl->vertex_buffer = vbuf;
@@ -26,7 +29,8 @@ static void remove_vertex_buf(bgl_instance bgl, int id) {
     while (*b) {
         if ((*b)->id == id) {
             bgl_vertex_buffer next = (*b)->next;
-            free((*b)->vertices);
+            bgl_aligned_free((*b)->vertices);
+            bgl_aligned_free((*b)->packed);
             free(*b);
             *b = next;
             --bgl->vbuf_cnt;
@@ -41,55 +45,84 @@ static void clear_vertex_buf(bgl_instance bgl) {
 
     while (b) {
         bgl_vertex_buffer next = b->next;
-        free(b->vertices);
+        bgl_aligned_free(b->vertices);
+        bgl_aligned_free(b->packed);
         free(b);
         b = next;
     }
     bgl->vbuf_cnt = 0;
 }
 
-static void draw_points(bgl_instance bgl, bgl_vertex_buffer buf, vertex_item *vertices) {
+static void vertex_buf_bounds(bgl_vertex_buffer buf) {
+    vec3 min = {FLT_MAX, FLT_MAX, FLT_MAX}, max = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    vec4 p;
+    float radius = 0;
+
+    if (!buf->count) {
+        glm_vec4_zero(buf->sphere);
+        return;
+    }
+
+    for (int i = 0; i < buf->count; ++i) {
+        vertex_buf_position(buf, i, p);
+        glm_vec3_minv(min, p, min);
+        glm_vec3_maxv(max, p, max);
+    }
+    glm_vec3_center(min, max, buf->sphere);
+    for (int i = 0; i < buf->count; ++i) {
+        vertex_buf_position(buf, i, p);
+        radius = glm_max(radius, glm_vec3_distance(buf->sphere, p));
+    }
+    buf->sphere[3] = radius;
+}
+
+static void draw_points(bgl_instance bgl, bgl_vertex_buffer buf, vertex_item *vertices, int first, int count) {
     ivec3 idxs;
+    vec4 tmp;
 
-    for (idxs[0] = buf->count; idxs[0]--;) {
+    for (idxs[0] = first + count; idxs[0]-- > first;) {
         vertices[idxs[0]].used = 1;
 
-        push_back_helper_buf_idx(bgl, buf->vitem_off, idxs, buf->vertices[idxs[0]].color, 1);
+        push_back_helper_buf_idx(bgl, buf->vitem_off, idxs, vertex_buf_color(buf, idxs[0], tmp), 1, BGL_CULL_NONE);
     }
 }
 
-static void draw_lines(bgl_instance bgl, bgl_vertex_buffer buf, vertex_item *vertices, bgl_drawing_modes mode) {
+static void draw_lines(bgl_instance bgl, bgl_vertex_buffer buf, vertex_item *vertices, int first, int count,
+                       bgl_drawing_modes mode) {
     ivec3 idxs;
+    vec4 tmp;
     int inc = (mode == BGL_LINES) ? 2 : 1;
 
-    for (int i = 0; i < buf->count - 1; i += inc) {
+    for (int i = first; i < first + count - 1; i += inc) {
         idxs[0] = i;
         idxs[1] = i + 1;
 
         vertices[idxs[0]].used = vertices[idxs[1]].used = 1;
 
-        push_back_helper_buf_idx(bgl, buf->vitem_off, idxs, buf->vertices[i].color, 2);
+        push_back_helper_buf_idx(bgl, buf->vitem_off, idxs, vertex_buf_color(buf, i, tmp), 2, BGL_CULL_NONE);
     }
 
     if (mode == BGL_LINES_LOOP) {
-        idxs[0] = 0;
+        idxs[0] = first;
 
-        push_back_helper_buf_idx(bgl, buf->vitem_off, idxs, buf->vertices[0].color, 2);
+        push_back_helper_buf_idx(bgl, buf->vitem_off, idxs, vertex_buf_color(buf, first, tmp), 2, BGL_CULL_NONE);
     }
 }
 
-static void draw_triangles(bgl_instance bgl, bgl_vertex_buffer buf, vertex_item *vertices, vec4 camera, vec4 light, bgl_drawing_modes mode) {
-    vec3 ray;
+static void draw_triangles(bgl_instance bgl, bgl_vertex_buffer buf, vertex_item *vertices, int first, int count,
+                           vec4 light, bgl_drawing_modes mode) {
     ivec3 idxs;
 
     vec4 color;
+    float *src;
     vec4 norm;
     vec3 light_color = GLM_VEC3_ONE_INIT;
     vec3 diffuse;
 
-    int is_strip = mode == BGL_TRIANGLES_STRIP, strip = 0, inc = is_strip ? 1 : 3;
+    // odd strip tris are flipped, counted from the start of the buffer
+    int is_strip = mode == BGL_TRIANGLES_STRIP, strip = is_strip && (first & 1), inc = is_strip ? 1 : 3;
 
-    for (int i = 0; i < buf->count - 2; i += inc) {
+    for (int i = first; i < first + count - 2; i += inc) {
         idxs[0] = i + (strip ? 1 : 0);
         idxs[1] = i + (strip ? 0 : 1);
         idxs[2] = i + 2;
@@ -100,35 +133,34 @@ static void draw_triangles(bgl_instance bgl, bgl_vertex_buffer buf, vertex_item
                         vertices[idxs[2]].vtx,
                         norm);
 
-        // back-face culling
-        glm_vec3_sub(vertices[idxs[0]].vtx, camera, ray);
-        if (glm_vec3_dot(norm, ray) >= 0)
-            continue;
-
-        float light_intencity = glm_max(glm_vec3_dot(norm, light), 0);
+        // faces are culled after projection, see draw_buffers
+        float light_intencity = face_light(norm, light, buf->cull_mode);
         glm_vec3_scale(light_color, light_intencity, diffuse);
-        glm_vec3_mul(diffuse, buf->vertices[i].color, color);
+        src = vertex_buf_color(buf, i, color);
+        glm_vec3_mul(diffuse, src, color);
+        color[3] = src[3];
 //        glm_vec3_clamp(color, 0, 1);
 
         vertices[idxs[0]].used = vertices[idxs[1]].used = vertices[idxs[2]].used = 1;
 
-        push_back_helper_buf_idx(bgl, buf->vitem_off, idxs, color, 3);
+        push_back_helper_buf_idx(bgl, buf->vitem_off, idxs, color, 3, buf->cull_mode);
     }
 }
 
-static void draw_triangles_fan(bgl_instance bgl, bgl_vertex_buffer buf, vertex_item *vertices, vec4 camera, vec4 light) {
-    vec3 ray;
+static void draw_triangles_fan(bgl_instance bgl, bgl_vertex_buffer buf, vertex_item *vertices, int first, int count,
+                               vec4 light) {
     ivec3 idxs;
 
     vec4 color;
+    float *src;
     vec4 norm;
     vec3 light_color = GLM_VEC3_ONE_INIT;
     vec3 diffuse;
 
-    idxs[0] = 0;
-    vertices[0].used = 1;
+    idxs[0] = first;
+    vertices[first].used = 1;
 
-    for (int i = 1; i < buf->count - 1; ++i) {
+    for (int i = first + 1; i < first + count - 1; ++i) {
         idxs[1] = i;
         idxs[2] = i + 1;
 
@@ -137,27 +169,64 @@ static void draw_triangles_fan(bgl_instance bgl, bgl_vertex_buffer buf, vertex_i
                         vertices[idxs[2]].vtx,
                         norm);
 
-        // back-face culling
-        glm_vec3_sub(vertices[idxs[0]].vtx, camera, ray);
-        if (glm_vec3_dot(norm, ray) >= 0)
-            continue;
-
-        float light_intencity = glm_max(glm_vec3_dot(norm, light), 0);
+        // faces are culled after projection, see draw_buffers
+        float light_intencity = face_light(norm, light, buf->cull_mode);
         glm_vec3_scale(light_color, light_intencity, diffuse);
-        glm_vec3_mul(diffuse, buf->vertices[i].color, color);
+        src = vertex_buf_color(buf, i, color);
+        glm_vec3_mul(diffuse, src, color);
+        color[3] = src[3];
 //        glm_vec3_clamp(color, 0, 1);
 
         vertices[idxs[0]].used = vertices[idxs[1]].used = 1;
 
-        push_back_helper_buf_idx(bgl, buf->vitem_off, idxs, color, 3);
+        push_back_helper_buf_idx(bgl, buf->vitem_off, idxs, color, 3, buf->cull_mode);
+    }
+}
+
+/*!
+ * @brief Contribution culling: whether the projected bounds are large enough to draw.
+ */
+int vertex_buf_contributes(bgl_instance bgl, bgl_vertex_buffer vbuf) {
+    if (vbuf->min_pixels <= 0)
+        return true;
+
+    float px = vertex_buf_pixel_scale(bgl, vbuf, bgl->frame.camera);
+
+    return px < 0 || 2.0f * vbuf->sphere[3] * px >= vbuf->min_pixels;
+}
+
+static void draw_vertex_buf(bgl_instance bgl, bgl_vertex_buffer buf, int first, int count, bgl_drawing_modes mode) {
+    bgl_drawing_modes true_mode = mode ?: buf->render_mode;
+    vertex_item *vertices = &bgl->frame.vertices[buf->vitem_off];
+
+    if (!vertex_buf_contributes(bgl, buf))
+        return;
+
+    switch (true_mode) {
+    case BGL_POINTS:
+        draw_points(bgl, buf, vertices, first, count);
+        break;
+    case BGL_LINES:
+    case BGL_LINES_STRIP:
+    case BGL_LINES_LOOP:
+        draw_lines(bgl, buf, vertices, first, count, true_mode);
+        break;
+    case BGL_TRIANGLES:
+    case BGL_TRIANGLES_STRIP:
+        draw_triangles(bgl, buf, vertices, first, count, bgl->frame.light, true_mode);
+        break;
+    case BGL_TRIANGLES_FAN:
+        draw_triangles_fan(bgl, buf, vertices, first, count, bgl->frame.light);
+        break;
+    default:
+        fprintf(stderr, "Invalid drawing mode: 0x%04X\n", true_mode);
+        break;
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 BGL_API int bgl_create_vertex_buffer(bgl_instance bgl, const vertex *vertices, int count, bgl_drawing_modes mode) {
-    static int new_id = 0;
-
     if (new_id == INT_MIN) {
         fprintf(stderr, "Failed to create vertex buffer: buffer limit reached\n");
         return -1;
@@ -166,6 +235,7 @@ BGL_API int bgl_create_vertex_buffer(bgl_instance bgl, const vertex *vertices, i
     bgl_vertex_buffer buf = malloc(sizeof(*buf));
     if (!(buf && (buf->vertices = bgl_aligned_alloc(16, count * sizeof(*vertices))))) {
         fprintf(stderr, "Failed to create vertex buffer: %s\n", strerror(errno));
+        free(buf);
         return -1;
     }
 
@@ -173,16 +243,78 @@ BGL_API int bgl_create_vertex_buffer(bgl_instance bgl, const vertex *vertices, i
     for (size_t i = 0; i < count; ++i)
         buf->vertices[i].pos[3] = 1.0f;
 
+    buf->packed = NULL;
+    buf->id = new_id++;
+    buf->count = count;
+    buf->render_mode = mode;
+    buf->model_m = NULL;
+    buf->min_pixels = 0;
+    buf->cull_mode = BGL_CULL_BACK;
+    vertex_buf_bounds(buf);
+
+    insert_vertex_buf(bgl, buf);
+
+    return buf->id;
+}
+
+BGL_API int bgl_create_vertex_buffer_packed(bgl_instance bgl, const vertex_packed *vertices, int count, mat4 dequant,
+                                            bgl_drawing_modes mode) {
+    if (new_id == INT_MIN) {
+        fprintf(stderr, "Failed to create vertex buffer: buffer limit reached\n");
+        return -1;
+    }
+
+    bgl_vertex_buffer buf = malloc(sizeof(*buf));
+    if (!(buf && (buf->packed = bgl_aligned_alloc(16, count * sizeof(*vertices))))) {
+        fprintf(stderr, "Failed to create vertex buffer: %s\n", strerror(errno));
+        free(buf);
+        return -1;
+    }
+
+    memcpy(buf->packed, vertices, count * sizeof(*vertices));
+    if (dequant)
+        glm_mat4_copy(dequant, buf->dequant);
+    else
+        glm_mat4_identity(buf->dequant);
+
+    buf->vertices = NULL;
     buf->id = new_id++;
     buf->count = count;
     buf->render_mode = mode;
     buf->model_m = NULL;
+    buf->min_pixels = 0;
+    buf->cull_mode = BGL_CULL_BACK;
+    vertex_buf_bounds(buf);
 
     insert_vertex_buf(bgl, buf);
 
     return buf->id;
 }
 
+BGL_API int bgl_set_contribution_cull(bgl_instance bgl, int vbuf_id, float min_pixels) {
+    for (bgl_vertex_buffer b = bgl->vertex_buffer; b; b = b->next) {
+        if (b->id == vbuf_id) {
+            b->min_pixels = min_pixels;
+            return true;
+        }
+    }
+    fprintf(stderr, "bgl_set_contribution_cull: Invalid vertex buffer ID: %i\n", vbuf_id);
+
+    return false;
+}
+
+BGL_API int bgl_set_vertex_buffer_cull_mode(bgl_instance bgl, int vbuf_id, bgl_cull_mode mode) {
+    for (bgl_vertex_buffer b = bgl->vertex_buffer; b; b = b->next) {
+        if (b->id == vbuf_id) {
+            b->cull_mode = mode;
+            return true;
+        }
+    }
+    fprintf(stderr, "bgl_set_vertex_buffer_cull_mode: Invalid vertex buffer ID: %i\n", vbuf_id);
+
+    return false;
+}
+
 BGL_API void bgl_remove_vertex_buffer(bgl_instance bgl, int id) {
     remove_vertex_buf(bgl, id);
 }
@@ -192,37 +324,43 @@ BGL_API void bgl_clear_vertex_bufers(bgl_instance bgl) {
 }
 
 BGL_API void bgl_draw_vertex_buffers(bgl_instance bgl, bgl_drawing_modes mode) {
-    mat4 vp;
-    vec4 camera, light;
-    vertex_item *vhb_buf, *vertices;
-
-    prepare_buffers(bgl, camera, light, vp, &vhb_buf);
-
-    for (bgl_vertex_buffer buf = bgl->vertex_buffer; buf; buf = buf->next) {
-        bgl_drawing_modes true_mode = mode ?: buf->render_mode;
-        vertices = &vhb_buf[buf->vitem_off];
-
-        switch (true_mode) {
-        case BGL_POINTS:
-            draw_points(bgl, buf, vertices);
-            break;
-        case BGL_LINES:
-        case BGL_LINES_STRIP:
-        case BGL_LINES_LOOP:
-            draw_lines(bgl, buf, vertices, true_mode);
-            break;
-        case BGL_TRIANGLES:
-        case BGL_TRIANGLES_STRIP:
-            draw_triangles(bgl, buf, vertices, camera, light, true_mode);
-            break;
-        case BGL_TRIANGLES_FAN:
-            draw_triangles_fan(bgl, buf, vertices, camera, light);
-            break;
-        default:
-            fprintf(stderr, "Invalid drawing mode: 0x%04X\n", true_mode);
-            break;
-        }
+    int in_frame = bgl->frame.active;
+
+    if (!in_frame)
+        bgl_begin_frame(bgl);
+
+    for (bgl_vertex_buffer buf = bgl->vertex_buffer; buf; buf = buf->next)
+        draw_vertex_buf(bgl, buf, 0, buf->count, mode);
+
+    if (!in_frame)
+        bgl_end_frame(bgl);
+}
+
+BGL_API int bgl_draw_vertex_buffer_range(bgl_instance bgl, int vbuf_id, int first, int count, bgl_drawing_modes mode) {
+    bgl_vertex_buffer buf = bgl->vertex_buffer;
+    int in_frame = bgl->frame.active;
+
+    for (; buf && buf->id != vbuf_id; buf = buf->next);
+    if (!buf) {
+        fprintf(stderr, "bgl_draw_vertex_buffer_range: Invalid vertex buffer ID: %i\n", vbuf_id);
+        return false;
+    }
+
+    if (first < 0 || count < 0 || first > buf->count) {
+        fprintf(stderr, "bgl_draw_vertex_buffer_range: Invalid range: %i, %i\n", first, count);
+        return false;
     }
+    if (count > buf->count - first)
+        count = buf->count - first;
+
+    if (!in_frame)
+        bgl_begin_frame(bgl);
+
+    if (count)
+        draw_vertex_buf(bgl, buf, first, count, mode);
+
+    if (!in_frame)
+        bgl_end_frame(bgl);
 
-    draw_buffers(bgl, vp);
+    return true;
 }
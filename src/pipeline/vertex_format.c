@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "internal.h"
+
+
+#define SNORM16_MAX 32767.0f
+
+static int16_t to_snorm16(float v) {
+    return (int16_t)lroundf(glm_clamp(v, -1.0f, 1.0f) * SNORM16_MAX);
+}
+
+static uint8_t to_unorm8(float v) {
+    return (uint8_t)lroundf(glm_clamp(v, 0.0f, 1.0f) * 255.0f);
+}
+
+static void oct_encode(const float *n, int16_t dst[2]) {
+    float l1 = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    float x, y;
+
+    if (l1 < FLT_MIN) {
+        dst[0] = dst[1] = 0;
+        return;
+    }
+
+    x = n[0] / l1;
+    y = n[1] / l1;
+    if (n[2] < 0) {
+        float t = x;
+        x = (1.0f - fabsf(y)) * (t >= 0 ? 1.0f : -1.0f);
+        y = (1.0f - fabsf(t)) * (y >= 0 ? 1.0f : -1.0f);
+    }
+
+    dst[0] = to_snorm16(x);
+    dst[1] = to_snorm16(y);
+}
+
+void oct_decode(const int16_t src[2], vec3 dst) {
+    float x = (float)src[0] / SNORM16_MAX, y = (float)src[1] / SNORM16_MAX;
+    float z = 1.0f - fabsf(x) - fabsf(y);
+    float t = glm_max(-z, 0.0f);
+
+    dst[0] = x + (x >= 0 ? -t : t);
+    dst[1] = y + (y >= 0 ? -t : t);
+    dst[2] = z;
+    glm_vec3_normalize(dst);
+}
+
+void unpack_rgba8(uint32_t c, vec4 dst) {
+    dst[0] = (float)(c & 0xFF) / 255.0f;
+    dst[1] = (float)(c >> 8 & 0xFF) / 255.0f;
+    dst[2] = (float)(c >> 16 & 0xFF) / 255.0f;
+    dst[3] = (float)(c >> 24) / 255.0f;
+}
+
+/*!
+ * @brief Position of the i-th vertex in model space.
+ */
+void vertex_buf_position(bgl_vertex_buffer buf, int i, vec4 dst) {
+    if (buf->packed) {
+        const int16_t *p = buf->packed[i].pos;
+        glm_mat4_mulv(buf->dequant, (vec4){p[0], p[1], p[2], 1.0f}, dst);
+    } else {
+        glm_vec4_copy(buf->vertices[i].pos, dst);
+    }
+}
+
+/*!
+ * @brief Color of the i-th vertex; packed colors are decoded into tmp.
+ */
+float *vertex_buf_color(bgl_vertex_buffer buf, int i, vec4 tmp) {
+    if (!buf->packed)
+        return buf->vertices[i].color;
+
+    unpack_rgba8(buf->packed[i].color, tmp);
+
+    return tmp;
+}
+
+/*!
+ * @brief Transform kernel for packed buffers.
+ * Dequantisation is folded into the model matrix, so a vertex costs one int to float
+ * conversion and one matrix multiply, the same as a float vertex.
+ */
+void transform_packed_vertices(bgl_vertex_buffer buf, mat4 *model, vertex_item *dst) {
+    mat4 m;
+
+    if (model)
+        glm_mat4_mul(*model, buf->dequant, m);
+    else
+        glm_mat4_copy(buf->dequant, m);
+
+    for (int j = 0; j < buf->count; ++j) {
+        const int16_t *p = buf->packed[j].pos;
+        glm_mat4_mulv(m, (vec4){p[0], p[1], p[2], 1.0f}, dst[j].vtx);
+        dst[j].used = 0;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BGL_API int bgl_pack_vertices(const vertex *src, int count, vertex_packed *dst, mat4 dequant) {
+    vec3 min = {FLT_MAX, FLT_MAX, FLT_MAX}, max = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    vec3 center, extent;
+
+    if (count <= 0) {
+        fprintf(stderr, "bgl_pack_vertices: Invalid vertex count: %i\n", count);
+        return false;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        glm_vec3_minv(min, (float *)src[i].pos, min);
+        glm_vec3_maxv(max, (float *)src[i].pos, max);
+    }
+    glm_vec3_center(min, max, center);
+    glm_vec3_sub(max, center, extent);
+    for (int k = 0; k < 3; ++k)
+        if (extent[k] < FLT_MIN)
+            extent[k] = 1.0f;
+
+    for (int i = 0; i < count; ++i) {
+        for (int k = 0; k < 3; ++k)
+            dst[i].pos[k] = to_snorm16((src[i].pos[k] - center[k]) / extent[k]);
+        dst[i].pos[3] = 0;
+
+        dst[i].color = (uint32_t)to_unorm8(src[i].color[0])
+                       | (uint32_t)to_unorm8(src[i].color[1]) << 8
+                       | (uint32_t)to_unorm8(src[i].color[2]) << 16
+                       | (uint32_t)to_unorm8(src[i].color[3]) << 24;
+
+        oct_encode(src[i].normal, dst[i].normal);
+    }
+
+    // snorm16 -> model space
+    glm_translate_make(dequant, center);
+    glm_scale(dequant, (vec3){extent[0] / SNORM16_MAX, extent[1] / SNORM16_MAX, extent[2] / SNORM16_MAX});
+
+    return true;
+}
+
+/*!
+ * @brief Inverse of bgl_pack_vertices, positions are mapped back to model space by dequant.
+ */
+BGL_API int bgl_unpack_vertices(const vertex_packed *src, int count, vertex *dst, mat4 dequant) {
+    if (count <= 0) {
+        fprintf(stderr, "bgl_unpack_vertices: Invalid vertex count: %i\n", count);
+        return false;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const int16_t *p = src[i].pos;
+
+        glm_mat4_mulv(dequant, (vec4){p[0], p[1], p[2], 1.0f}, dst[i].pos);
+        unpack_rgba8(src[i].color, dst[i].color);
+        oct_decode(src[i].normal, dst[i].normal);
+    }
+
+    return true;
+}
@@ -12,6 +12,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 BGL_API void bgl_set_viewport(bgl_instance bgl, bgl_viewport *vp) {
+    bgl->viewport.src = *vp;
+
     if ((bgl->viewport.x = vp->x) < 0)
         ++bgl->viewport.x;
     else if (bgl->viewport.x > 0)
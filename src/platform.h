@@ -35,6 +35,16 @@
 //        pthread_mutex_t mutex;
 #endif
 
+#if defined(_WIN32)
+# include <windows.h>
+typedef HANDLE bgl_platform_thread;
+typedef CRITICAL_SECTION bgl_platform_mutex;
+#else
+# include <pthread.h>
+typedef pthread_t bgl_platform_thread;
+typedef pthread_mutex_t bgl_platform_mutex;
+#endif
+
 
 /// basic
 
@@ -47,6 +57,26 @@ void terminate_platform(bgl_instance bgl);
 void init_platform_timer(bgl_instance bgl);
 uint64_t get_platform_timer_value(bgl_instance bgl);
 uint64_t get_platform_timer_freq(bgl_instance bgl);
+void sleep_platform_timer_until(bgl_instance bgl, uint64_t deadline);
+
+
+/// file
+
+void *map_platform_file(const char *path, size_t *size);
+void unmap_platform_file(void *data, size_t size);
+int stat_platform_file(const char *path, uint64_t *size, int64_t *mtime);
+int replace_platform_file(const char *from, const char *to);
+
+
+/// thread
+
+int create_platform_thread(bgl_platform_thread *thread, void (*fn)(void *arg), void *arg);
+void join_platform_thread(bgl_platform_thread thread);
+int get_platform_cpu_count(void);
+int init_platform_mutex(bgl_platform_mutex *mutex);
+void destroy_platform_mutex(bgl_platform_mutex *mutex);
+void lock_platform_mutex(bgl_platform_mutex *mutex);
+void unlock_platform_mutex(bgl_platform_mutex *mutex);
 
 
 /// window
@@ -57,9 +87,9 @@ void destroy_platform_window(bgl_instance bgl);
 void show_platform_window(bgl_instance bgl);
 void set_platform_window_title(bgl_instance bgl, const char *title);
 int is_visible_platform_window(bgl_instance bgl);
-//void get_platform_window_size(bgl_instance bgl, int *width, int *height);
+void get_platform_window_size(bgl_instance bgl, int *width, int *height);
 //void set_platform_window_size(bgl_instance bgl, int width, int height);
-//void get_platform_framebuffer_size(bgl_instance bgl, int *width, int *height);
+void get_platform_framebuffer_size(bgl_instance bgl, int *width, int *height);
 
 
 /// window events
@@ -68,6 +98,9 @@ void poll_platform_window_events(bgl_instance bgl);
 void wait_platform_window_events(bgl_instance bgl);
 void wait_platform_window_events_timeout(bgl_instance bgl, double t);
 void send_platform_window_empty_event(bgl_instance bgl);
+int watch_platform_fd(bgl_instance bgl, int fd, bgl_fd_events events, bgl_fd_fn callback, void *user);
+int unwatch_platform_fd(bgl_instance bgl, int fd);
+int get_platform_event_fd(bgl_instance bgl);
 
 
 #endif // BGL_PLATFORM_H
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <bgl/bgl.h>
+
+#include "internal.h"
+
+
+void *map_platform_file(const char *path, size_t *size) {
+    struct stat st;
+    void *data = NULL;
+    int err = 0;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+        return NULL;
+
+    if (fstat(fd, &st)) {
+        err = errno;
+        goto end;
+    }
+
+    // mmap rejects zero length, an empty file maps to an empty string
+    if (!(*size = (size_t)st.st_size)) {
+        data = "";
+        goto end;
+    }
+
+    data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        err = errno;
+        data = NULL;
+        goto end;
+    }
+    madvise(data, *size, MADV_SEQUENTIAL);
+
+end:
+    close(fd);
+    errno = err;
+
+    return data;
+}
+
+void unmap_platform_file(void *data, size_t size) {
+    if (size)
+        munmap(data, size);
+}
+
+int stat_platform_file(const char *path, uint64_t *size, int64_t *mtime) {
+    struct stat st;
+
+    if (stat(path, &st))
+        return false;
+
+    *size = (uint64_t)st.st_size;
+#if defined(__APPLE__)
+    *mtime = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    *mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+
+    return true;
+}
+
+/*!
+ * @brief Atomically move from over to, existing mappings of to keep the old file.
+ */
+int replace_platform_file(const char *from, const char *to) {
+    return !rename(from, to);
+}
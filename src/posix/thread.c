@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <bgl/bgl.h>
+
+#include "internal.h"
+
+
+typedef struct {
+    void (*fn)(void *arg);
+    void *arg;
+} thread_start;
+
+static void *thread_main(void *arg) {
+    thread_start start = *(thread_start *)arg;
+
+    free(arg);
+    start.fn(start.arg);
+
+    return NULL;
+}
+
+int create_platform_thread(bgl_platform_thread *thread, void (*fn)(void *arg), void *arg) {
+    thread_start *start = malloc(sizeof(*start));
+
+    if (!start)
+        return false;
+
+    start->fn = fn;
+    start->arg = arg;
+    if (pthread_create(thread, NULL, thread_main, start)) {
+        free(start);
+        return false;
+    }
+
+    return true;
+}
+
+void join_platform_thread(bgl_platform_thread thread) {
+    pthread_join(thread, NULL);
+}
+
+int get_platform_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+int init_platform_mutex(bgl_platform_mutex *mutex) {
+    return !pthread_mutex_init(mutex, NULL);
+}
+
+void destroy_platform_mutex(bgl_platform_mutex *mutex) {
+    pthread_mutex_destroy(mutex);
+}
+
+void lock_platform_mutex(bgl_platform_mutex *mutex) {
+    pthread_mutex_lock(mutex);
+}
+
+void unlock_platform_mutex(bgl_platform_mutex *mutex) {
+    pthread_mutex_unlock(mutex);
+}
@@ -9,6 +9,7 @@
 #define _GNU_SOURCE
 #endif
 
+#include <errno.h>
 #include <unistd.h>
 #include <time.h>
 
@@ -21,17 +22,19 @@
 
 
 void init_platform_timer(bgl_instance bgl) {
+    struct timespec ts;
+
     bgl->timer.freq = S2NS;
+    bgl->timer.id = CLOCK_REALTIME;
 
 #if defined(_POSIX_MONOTONIC_CLOCK)
-    struct timespec ts;
     if (!clock_gettime(CLOCK_MONOTONIC_RAW, &ts))
         bgl->timer.id = CLOCK_MONOTONIC_RAW;
     else if (!clock_gettime(CLOCK_MONOTONIC, &ts))
         bgl->timer.id = CLOCK_MONOTONIC;
 #endif
-        bgl->timer.id = CLOCK_REALTIME;
 
+    clock_gettime(bgl->timer.id, &ts);
     bgl->timer.offset = (uint64_t)ts.tv_sec * bgl->timer.freq + (uint64_t)ts.tv_nsec;
 }
 
@@ -44,3 +47,23 @@ uint64_t get_platform_timer_value(bgl_instance bgl) {
 uint64_t get_platform_timer_freq(bgl_instance bgl) {
     return bgl->timer.freq;
 }
+
+void sleep_platform_timer_until(bgl_instance bgl, uint64_t deadline) {
+    uint64_t now = get_platform_timer_value(bgl);
+    clockid_t id = bgl->timer.id;
+    struct timespec ts;
+
+    if (deadline <= now)
+        return;
+
+    // clock_nanosleep refuses CLOCK_MONOTONIC_RAW, rebase the deadline onto CLOCK_MONOTONIC
+    if (id != CLOCK_MONOTONIC && id != CLOCK_REALTIME) {
+        id = CLOCK_MONOTONIC;
+        clock_gettime(id, &ts);
+        deadline = (uint64_t)ts.tv_sec * S2NS + (uint64_t)ts.tv_nsec + (deadline - now);
+    }
+
+    ts.tv_sec = (time_t)(deadline / S2NS);
+    ts.tv_nsec = (long)(deadline % S2NS);
+    while (clock_nanosleep(id, TIMER_ABSTIME, &ts, NULL) == EINTR);
+}
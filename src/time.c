@@ -5,7 +5,11 @@
  * Full license can be found in the LICENSE file
  */
 
+#include <limits.h>
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <bgl/bgl.h>
 
@@ -31,3 +35,170 @@ BGL_API uint64_t bgl_get_timer(bgl_instance bgl) {
 BGL_API uint64_t bgl_get_timer_freq(bgl_instance bgl) {
     return get_platform_timer_freq(bgl);
 }
+
+/*!
+ * @brief Limit the frame rate of the bgl_frame_begin/bgl_frame_end loop, 0 removes the limit.
+ */
+BGL_API void bgl_set_target_fps(bgl_instance bgl, double fps) {
+    if (fps < 0) {
+        fprintf(stderr, "set_target_fps: Invalid fps %f\n", fps);
+        return;
+    }
+    bgl->pacing.period = fps > 0 ? (uint64_t)((double)get_platform_timer_freq(bgl) / fps) : 0;
+    bgl->pacing.deadline = 0;
+    if (!bgl->pacing.slack)
+        bgl->pacing.slack = get_platform_timer_freq(bgl) / 1000;
+}
+
+/*!
+ * @brief Mark the start of a frame. Not related to bgl_begin_frame, which scopes draw state.
+ * @return Seconds since the previous frame began, 0 for the first one.
+ */
+BGL_API double bgl_frame_begin(bgl_instance bgl) {
+    uint64_t now = get_platform_timer_value(bgl), prev = bgl->pacing.start;
+
+    bgl->pacing.start = now;
+    if (!bgl->pacing.deadline)
+        bgl->pacing.deadline = now + bgl->pacing.period;
+
+    return prev ? (double)(now - prev) / (double)get_platform_timer_freq(bgl) : 0;
+}
+
+/*!
+ * @brief Wait until the frame deadline: a coarse sleep that wakes up slack ticks early, then a spin.
+ * @return Number of deadlines missed by this frame, 0 when it was on time.
+ */
+BGL_API int bgl_frame_end(bgl_instance bgl) {
+    uint64_t period = bgl->pacing.period, deadline = bgl->pacing.deadline, now;
+
+    if (!period)
+        return 0;
+
+    now = get_platform_timer_value(bgl);
+    if (!deadline)
+        deadline = now;
+
+    if (now > deadline) {
+        // skip the lost slots and stay on the original grid
+        uint64_t missed = (now - deadline) / period + 1;
+        bgl->pacing.deadline = deadline + missed * period;
+        bgl->pacing.missed += missed;
+        return missed > INT_MAX ? INT_MAX : (int)missed;
+    }
+
+    uint64_t slack = bgl->pacing.slack, min_slack = get_platform_timer_freq(bgl) / 10000;
+    if (deadline - now > slack) {
+        uint64_t wake = deadline - slack;
+        sleep_platform_timer_until(bgl, wake);
+
+        // keep the slack around twice the worst recent oversleep
+        now = get_platform_timer_value(bgl);
+        uint64_t late = now > wake ? now - wake : 0;
+        slack -= slack / 16;
+        if (slack < late * 2)
+            slack = late * 2;
+        if (slack < min_slack)
+            slack = min_slack;
+        if (slack > period / 2)
+            slack = period / 2;
+        bgl->pacing.slack = slack;
+    }
+
+    while (get_platform_timer_value(bgl) < deadline)
+        bgl_cpu_relax();
+
+    bgl->pacing.deadline = deadline + period;
+
+    return 0;
+}
+
+BGL_API uint64_t bgl_get_missed_frames(bgl_instance bgl) {
+    return bgl->pacing.missed;
+}
+
+
+/// frame statistics
+
+void record_frame_time(bgl_instance bgl) {
+    uint64_t now = get_platform_timer_value(bgl), last = bgl->stats.last;
+
+    bgl->stats.last = now;
+    if (!last)
+        return;
+
+    // single writer: publish the slot before advancing the head, the fence orders the
+    // previous head store before the slot store for the readers checking for laps
+    uint_fast64_t head = atomic_load_explicit(&bgl->stats.head, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&bgl->stats.times[head % FRAME_STATS_SIZE], now - last, memory_order_relaxed);
+    atomic_store_explicit(&bgl->stats.head, head + 1, memory_order_release);
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double frame_percentile(const uint64_t *sorted, int n, double p, double freq) {
+    int i = (int)ceil(p * n) - 1;
+    return (double)sorted[i < 0 ? 0 : i] / freq;
+}
+
+/*!
+ * @brief Summarize the last frames recorded by bgl_swap_buffers, safe to call from any thread.
+ * @return Number of frames summarized.
+ */
+BGL_API int bgl_get_frame_stats(bgl_instance bgl, bgl_frame_stats *stats) {
+    uint64_t times[FRAME_STATS_SIZE];
+    double freq = (double)get_platform_timer_freq(bgl);
+
+    uint_fast64_t head = atomic_load_explicit(&bgl->stats.head, memory_order_acquire);
+    uint_fast64_t base = atomic_load_explicit(&bgl->stats.base, memory_order_relaxed);
+    uint_fast64_t n = head > base ? head - base : 0, first;
+    if (n > FRAME_STATS_SIZE)
+        n = FRAME_STATS_SIZE;
+    first = head - n;
+
+    for (uint_fast64_t i = 0; i < n; ++i)
+        times[i] = atomic_load_explicit(&bgl->stats.times[(first + i) % FRAME_STATS_SIZE], memory_order_relaxed);
+
+    // drop the slots the writer lapped while they were copied,
+    // the slot at the head may be in the middle of being overwritten
+    atomic_thread_fence(memory_order_acquire);
+    uint_fast64_t now_head = atomic_load_explicit(&bgl->stats.head, memory_order_relaxed) + 1;
+    uint_fast64_t lapped = now_head > first + FRAME_STATS_SIZE ? now_head - first - FRAME_STATS_SIZE : 0;
+    if (lapped > n)
+        lapped = n;
+
+    uint64_t *t = &times[lapped];
+    int cnt = (int)(n - lapped);
+
+    memset(stats, 0, sizeof(*stats));
+    stats->count = cnt;
+    if (!cnt)
+        return 0;
+
+    uint64_t sum = 0;
+    for (int i = 0; i < cnt; ++i)
+        sum += t[i];
+
+    qsort(t, cnt, sizeof(*t), cmp_u64);
+    stats->mean = (double)sum / cnt / freq;
+    stats->p50 = frame_percentile(t, cnt, 0.50, freq);
+    stats->p95 = frame_percentile(t, cnt, 0.95, freq);
+    stats->p99 = frame_percentile(t, cnt, 0.99, freq);
+    stats->max = (double)t[cnt - 1] / freq;
+
+    // the median lands in bin 16, so the histogram spans four typical frames
+    stats->bin_width = stats->p50 > 0 ? stats->p50 / 16 : 1 / freq;
+    for (int i = 0; i < cnt; ++i) {
+        double bin = (double)t[i] / freq / stats->bin_width;
+        ++stats->histogram[bin < BGL_FRAME_STATS_BINS - 1 ? (int)bin : BGL_FRAME_STATS_BINS - 1];
+    }
+
+    return cnt;
+}
+
+BGL_API void bgl_reset_frame_stats(bgl_instance bgl) {
+    atomic_store_explicit(&bgl->stats.base, atomic_load(&bgl->stats.head), memory_order_relaxed);
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <bgl/bglt.h>
+
+#include "internal.h"
+
+
+struct bgl_load_job {
+    bgl_load_job next;
+    bgl_instance bgl;
+    bgl_platform_thread thread;
+
+    char *path;
+    bgl_obj_loaded_fn callback;
+    void *user;
+
+    bgl_obj_t *obj;
+    int err;
+    int done;
+};
+
+static void load_job(void *arg) {
+    bgl_load_job job = arg;
+    bgl_instance bgl = job->bgl;
+    bgl_obj_t *obj = bgl_load_obj(job->path);
+    int err = obj ? 0 : errno;
+
+    lock_platform_mutex(&bgl->loader.lock);
+    job->obj = obj;
+    job->err = err;
+    job->done = true;
+    unlock_platform_mutex(&bgl->loader.lock);
+
+    // the job may be freed from here on
+    send_platform_window_empty_event(bgl);
+}
+
+static void free_job(bgl_load_job job) {
+    free(job->path);
+    free(job);
+}
+
+/*!
+ * @brief Run the callbacks of finished loads on the calling thread.
+ * Only the event thread links and unlinks jobs, workers just mark them done.
+ */
+void dispatch_loaded_objs(bgl_instance bgl) {
+    bgl_load_job done = NULL;
+
+    if (!bgl->loader.jobs)
+        return;
+
+    lock_platform_mutex(&bgl->loader.lock);
+    for (bgl_load_job *j = &bgl->loader.jobs; *j;) {
+        if ((*j)->done) {
+            bgl_load_job d = *j;
+            *j = d->next;
+            d->next = done;
+            done = d;
+        } else {
+            j = &(*j)->next;
+        }
+    }
+    unlock_platform_mutex(&bgl->loader.lock);
+
+    while (done) {
+        bgl_load_job next = done->next;
+
+        join_platform_thread(done->thread);
+        done->callback(bgl, done->obj, done->err, done->user);
+        free_job(done);
+        done = next;
+    }
+}
+
+void finish_load_jobs(bgl_instance bgl) {
+    bgl_load_job j = bgl->loader.jobs;
+
+    while (j) {
+        bgl_load_job next = j->next;
+
+        join_platform_thread(j->thread);
+        if (j->obj)
+            bgl_destroy_obj(j->obj);
+        free_job(j);
+        j = next;
+    }
+    bgl->loader.jobs = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BGL_API int bgl_load_obj_async(bgl_instance bgl, const char *path, bgl_obj_loaded_fn callback, void *user) {
+    bgl_load_job job = calloc(1, sizeof(*job));
+
+    if (!(job && (job->path = strdup(path)))) {
+        fprintf(stderr, "Failed to load %s: %s\n", path, strerror(errno));
+        free(job);
+        return false;
+    }
+
+    job->bgl = bgl;
+    job->callback = callback;
+    job->user = user;
+
+    lock_platform_mutex(&bgl->loader.lock);
+    job->next = bgl->loader.jobs;
+    bgl->loader.jobs = job;
+    unlock_platform_mutex(&bgl->loader.lock);
+
+    if (!create_platform_thread(&job->thread, load_job, job)) {
+        fprintf(stderr, "Failed to load %s: unable to start a loader thread\n", path);
+        lock_platform_mutex(&bgl->loader.lock);
+        bgl->loader.jobs = job->next;
+        unlock_platform_mutex(&bgl->loader.lock);
+        free_job(job);
+        return false;
+    }
+
+    return true;
+}
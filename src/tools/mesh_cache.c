@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <bgl/bglt.h>
+
+#include "internal.h"
+
+
+#define MESH_CACHE_MAGIC    "BGLM"
+#define MESH_CACHE_VERSION  1
+#define MESH_CACHE_ALIGN    16
+
+#ifndef ESTALE
+# define ESTALE EINVAL
+#endif
+
+#define ALIGN_UP(x) (((x) + (MESH_CACHE_ALIGN - 1)) & ~(uint64_t)(MESH_CACHE_ALIGN - 1))
+
+/*
+ * Layout: header, group records, names, then 16 bytes aligned vertex and index arrays
+ * in the native `vertex` and `vindex` representation.
+ */
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t vertex_size;
+    uint32_t vindex_size;
+    uint64_t src_size;
+    int64_t src_mtime;
+    uint32_t v_cnt;
+    uint32_t group_cnt;
+    uint64_t v_off;
+} mesh_cache_header;
+
+typedef struct {
+    uint64_t name_off;  // 0 for an unnamed group
+    uint64_t i_off;
+    uint32_t name_len;
+    uint32_t i_cnt;
+    float min[3];
+    float max[3];
+} mesh_cache_group;
+
+static int write_pad(FILE *f, uint64_t *off) {
+    static const char zero[MESH_CACHE_ALIGN] = {0};
+    uint64_t n = ALIGN_UP(*off) - *off;
+
+    *off += n;
+
+    return fwrite(zero, 1, n, f) == n;
+}
+
+static int validate_cache(const char *data, size_t size) {
+    const mesh_cache_header *hdr = (const mesh_cache_header *)data;
+
+    if (size < sizeof(*hdr) || memcmp(hdr->magic, MESH_CACHE_MAGIC, 4)
+            || hdr->version != MESH_CACHE_VERSION
+            || hdr->vertex_size != sizeof(vertex) || hdr->vindex_size != sizeof(vindex))
+        return false;
+
+    if (hdr->group_cnt > (size - sizeof(*hdr)) / sizeof(mesh_cache_group)
+            || hdr->v_off > size || hdr->v_off % MESH_CACHE_ALIGN
+            || hdr->v_cnt > (size - hdr->v_off) / sizeof(vertex))
+        return false;
+
+    const mesh_cache_group *g = (const mesh_cache_group *)(hdr + 1);
+    for (uint32_t i = 0; i < hdr->group_cnt; ++i, ++g) {
+        if (g->name_off && (g->name_off >= size || g->name_len >= size - g->name_off
+                            || data[g->name_off + g->name_len]))
+            return false;
+        if (g->i_off > size || g->i_off % MESH_CACHE_ALIGN || g->i_cnt > (size - g->i_off) / sizeof(vindex))
+            return false;
+
+        // the mapping is handed out as is, indices are checked once here
+        const vindex *ind = (const vindex *)&data[g->i_off];
+        for (uint32_t k = 0; k < g->i_cnt; ++k)
+            if (ind[k].idx < 0 || (uint64_t)ind[k].idx >= hdr->v_cnt)
+                return false;
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BGL_API int bgl_write_mesh_cache(const char *path, const bgl_obj_t *obj, const char *src_path) {
+    mesh_cache_header hdr = {
+            .magic = MESH_CACHE_MAGIC,
+            .version = MESH_CACHE_VERSION,
+            .vertex_size = sizeof(vertex),
+            .vindex_size = sizeof(vindex),
+            .v_cnt = obj->v_cnt,
+            .group_cnt = obj->group_cnt,
+    };
+    mesh_cache_group *groups;
+    uint64_t off;
+    int ok = false;
+    char *tmp_path;
+    FILE *f;
+
+    if (src_path && !stat_platform_file(src_path, &hdr.src_size, &hdr.src_mtime)) {
+        fprintf(stderr, "Failed to write mesh cache: %s: %s\n", src_path, strerror(errno));
+        return false;
+    }
+
+    if (!(groups = calloc(obj->group_cnt + 1, sizeof(*groups)))) {
+        fprintf(stderr, "Failed to write mesh cache: %s\n", strerror(errno));
+        return false;
+    }
+
+    // names follow the group records, arrays start at the next aligned offset
+    off = sizeof(hdr) + obj->group_cnt * sizeof(*groups);
+    for (int i = 0; i < obj->group_cnt; ++i) {
+        if (obj->groups[i].name) {
+            groups[i].name_off = off;
+            groups[i].name_len = strlen(obj->groups[i].name);
+            off += groups[i].name_len + 1;
+        }
+    }
+    off = hdr.v_off = ALIGN_UP(off);
+    off += (uint64_t)obj->v_cnt * sizeof(vertex);
+    for (int i = 0; i < obj->group_cnt; ++i) {
+        off = groups[i].i_off = ALIGN_UP(off);
+        groups[i].i_cnt = obj->groups[i].i_cnt;
+        off += (uint64_t)groups[i].i_cnt * sizeof(vindex);
+        memcpy(groups[i].min, obj->groups[i].min, sizeof(vec3));
+        memcpy(groups[i].max, obj->groups[i].max, sizeof(vec3));
+    }
+
+    // written aside and moved over the cache, so live mappings of it never see a truncated file
+    if (!(tmp_path = malloc(strlen(path) + sizeof(".tmp")))) {
+        fprintf(stderr, "Failed to write mesh cache: %s\n", strerror(errno));
+        free(groups);
+        return false;
+    }
+    strcat(strcpy(tmp_path, path), ".tmp");
+
+    if (!(f = fopen(tmp_path, "wb"))) {
+        fprintf(stderr, "Failed to write mesh cache: %s: %s\n", tmp_path, strerror(errno));
+        free(tmp_path);
+        free(groups);
+        return false;
+    }
+
+    off = sizeof(hdr) + obj->group_cnt * sizeof(*groups);
+    if (fwrite(&hdr, sizeof(hdr), 1, f) != 1
+            || fwrite(groups, sizeof(*groups), obj->group_cnt, f) != (size_t)obj->group_cnt)
+        goto end;
+    for (int i = 0; i < obj->group_cnt; ++i) {
+        if (obj->groups[i].name && fwrite(obj->groups[i].name, groups[i].name_len + 1, 1, f) != 1)
+            goto end;
+        off += obj->groups[i].name ? groups[i].name_len + 1 : 0;
+    }
+    if (!write_pad(f, &off)
+            || fwrite(obj->vertices, sizeof(vertex), obj->v_cnt, f) != (size_t)obj->v_cnt)
+        goto end;
+    off += (uint64_t)obj->v_cnt * sizeof(vertex);
+    for (int i = 0; i < obj->group_cnt; ++i) {
+        if (!write_pad(f, &off)
+                || fwrite(obj->groups[i].indices, sizeof(vindex), groups[i].i_cnt, f) != groups[i].i_cnt)
+            goto end;
+        off += (uint64_t)groups[i].i_cnt * sizeof(vindex);
+    }
+    ok = true;
+
+end:
+    if (fclose(f))
+        ok = false;
+    if (ok && !replace_platform_file(tmp_path, path))
+        ok = false;
+    if (!ok) {
+        fprintf(stderr, "Failed to write mesh cache: %s: %s\n", path, strerror(errno));
+        remove(tmp_path);
+    }
+    free(tmp_path);
+    free(groups);
+
+    return ok;
+}
+
+BGL_API bgl_mesh_cache_t *bgl_open_mesh_cache(const char *path, const char *src_path) {
+    bgl_mesh_cache_t *cache;
+    const mesh_cache_header *hdr;
+    const char *data;
+    size_t size;
+    uint64_t src_size;
+    int64_t src_mtime;
+
+    if (!(data = map_platform_file(path, &size)))
+        return NULL;
+
+    hdr = (const mesh_cache_header *)data;
+    if (!validate_cache(data, size)) {
+        unmap_platform_file((void *)data, size);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    // a cache without its source is used as is
+    if (src_path && stat_platform_file(src_path, &src_size, &src_mtime)
+            && (src_size != hdr->src_size || src_mtime != hdr->src_mtime)) {
+        unmap_platform_file((void *)data, size);
+        errno = ESTALE;
+        return NULL;
+    }
+
+    bgl_mesh_cache_group_t *groups;
+    if (!((cache = calloc(1, sizeof(*cache))) && (groups = calloc(hdr->group_cnt + 1, sizeof(*groups))))) {
+        int err = errno;
+        free(cache);
+        unmap_platform_file((void *)data, size);
+        errno = err;
+        return NULL;
+    }
+
+    const mesh_cache_group *g = (const mesh_cache_group *)(hdr + 1);
+    for (uint32_t i = 0; i < hdr->group_cnt; ++i, ++g) {
+        groups[i].name = g->name_off ? &data[g->name_off] : NULL;
+        groups[i].indices = (const vindex *)&data[g->i_off];
+        groups[i].i_cnt = (int)g->i_cnt;
+        glm_vec3_copy((float *)g->min, groups[i].min);
+        glm_vec3_copy((float *)g->max, groups[i].max);
+    }
+
+    cache->vertices = (const vertex *)&data[hdr->v_off];
+    cache->v_cnt = (int)hdr->v_cnt;
+    cache->groups = groups;
+    cache->group_cnt = (int)hdr->group_cnt;
+    cache->map = (void *)data;
+    cache->map_size = size;
+
+    return cache;
+}
+
+BGL_API bgl_mesh_cache_t *bgl_load_obj_cached(const char *obj_path, const char *cache_path) {
+    bgl_mesh_cache_t *cache;
+    bgl_obj_t *obj;
+
+    if ((cache = bgl_open_mesh_cache(cache_path, obj_path)))
+        return cache;
+
+    if (!(obj = bgl_load_obj_mt(obj_path, 0)))
+        return NULL;
+
+    int ok = bgl_write_mesh_cache(cache_path, obj, obj_path);
+    bgl_destroy_obj(obj);
+
+    return ok ? bgl_open_mesh_cache(cache_path, obj_path) : NULL;
+}
+
+BGL_API void bgl_close_mesh_cache(bgl_mesh_cache_t *cache) {
+    unmap_platform_file(cache->map, cache->map_size);
+    free((void *)cache->groups);
+    free(cache);
+}
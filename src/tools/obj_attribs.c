@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+#include <bgl/bglt.h>
+
+#include "internal.h"
+
+
+#if defined(__SSE2__)
+BGL_INLINE __m128 cross_ps(__m128 a, __m128 b) {
+    __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+    return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+BGL_INLINE float dot3_ps(__m128 a, __m128 b) {
+    __m128 m = _mm_mul_ps(a, b);
+    m = _mm_add_ss(m, _mm_add_ss(_mm_shuffle_ps(m, m, 1), _mm_shuffle_ps(m, m, 2)));
+    return _mm_cvtss_f32(m);
+}
+#endif
+
+static int is_zero3(const float *v) {
+    return v[0] == 0 && v[1] == 0 && v[2] == 0;
+}
+
+/*!
+ * @brief Area weighted smooth normals for the vertices that came without one.
+ * The unnormalized face cross product is twice the area, so plain summation weights by area.
+ */
+int compute_obj_normals(bgl_obj_t *obj) {
+    unsigned char *need;
+    float *acc;
+    int cnt = 0;
+
+    if (!(need = calloc(obj->v_cnt + 1, 1)))
+        return errno;
+    for (int i = 0; i < obj->v_cnt; ++i)
+        cnt += need[i] = is_zero3(obj->vertices[i].normal);
+    if (!cnt) {
+        free(need);
+        return 0;
+    }
+
+    if (!(acc = bgl_aligned_alloc(16, (obj->v_cnt + 1) * 4 * sizeof(float)))) {
+        free(need);
+        return errno;
+    }
+    memset(acc, 0, (obj->v_cnt + 1) * 4 * sizeof(float));
+
+    for (const bgl_obj_group_t *grp = obj->groups; grp < &obj->groups[obj->group_cnt]; ++grp) {
+        const vindex *ind = grp->indices;
+
+        for (int i = 0; i + 2 < grp->i_cnt; i += 3) {
+            int a = ind[i].idx, b = ind[i + 1].idx, c = ind[i + 2].idx;
+            if (!(need[a] | need[b] | need[c]))
+                continue;
+
+#if defined(__SSE2__)
+            __m128 pa = _mm_loadu_ps(obj->vertices[a].pos);
+            __m128 n = cross_ps(_mm_sub_ps(_mm_loadu_ps(obj->vertices[b].pos), pa),
+                                _mm_sub_ps(_mm_loadu_ps(obj->vertices[c].pos), pa));
+            if (need[a])
+                _mm_store_ps(&acc[a * 4], _mm_add_ps(_mm_load_ps(&acc[a * 4]), n));
+            if (need[b])
+                _mm_store_ps(&acc[b * 4], _mm_add_ps(_mm_load_ps(&acc[b * 4]), n));
+            if (need[c])
+                _mm_store_ps(&acc[c * 4], _mm_add_ps(_mm_load_ps(&acc[c * 4]), n));
+#else
+            vec3 e1, e2, n;
+            glm_vec3_sub(obj->vertices[b].pos, obj->vertices[a].pos, e1);
+            glm_vec3_sub(obj->vertices[c].pos, obj->vertices[a].pos, e2);
+            glm_vec3_cross(e1, e2, n);
+            for (int k = 0; k < 3; ++k) {
+                int v = k ? k == 1 ? b : c : a;
+                if (need[v])
+                    glm_vec3_add(&acc[v * 4], n, &acc[v * 4]);
+            }
+#endif
+        }
+    }
+
+    for (int i = 0; i < obj->v_cnt; ++i) {
+        float *n = &acc[i * 4];
+        if (!need[i])
+            continue;
+        float len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len > 0)
+            glm_vec3_scale(n, 1.0f / len, obj->vertices[i].normal);
+    }
+
+    // corners follow their vertex, as they do when the file has normals
+    for (bgl_obj_group_t *grp = obj->groups; grp < &obj->groups[obj->group_cnt]; ++grp)
+        for (int i = 0; i < grp->i_cnt; ++i)
+            if (need[grp->indices[i].idx])
+                glm_vec3_copy(obj->vertices[grp->indices[i].idx].normal, grp->indices[i].normal);
+
+    bgl_aligned_free(acc);
+    free(need);
+
+    return 0;
+}
+
+/*!
+ * @brief Box and bounding sphere of the vertices each group references.
+ */
+void compute_obj_bounds(bgl_obj_t *obj) {
+    for (bgl_obj_group_t *grp = obj->groups; grp < &obj->groups[obj->group_cnt]; ++grp) {
+        const vindex *ind = grp->indices;
+        float r2 = 0;
+
+        if (!grp->i_cnt) {
+            glm_vec3_zero(grp->min);
+            glm_vec3_zero(grp->max);
+            glm_vec3_zero(grp->center);
+            grp->radius = 0;
+            continue;
+        }
+
+#if defined(__SSE2__)
+        __m128 lo = _mm_loadu_ps(obj->vertices[ind[0].idx].pos), hi = lo;
+        for (int i = 1; i < grp->i_cnt; ++i) {
+            __m128 p = _mm_loadu_ps(obj->vertices[ind[i].idx].pos);
+            lo = _mm_min_ps(lo, p);
+            hi = _mm_max_ps(hi, p);
+        }
+        __m128 c = _mm_mul_ps(_mm_add_ps(lo, hi), _mm_set1_ps(0.5f));
+        for (int i = 0; i < grp->i_cnt; ++i) {
+            __m128 d = _mm_sub_ps(_mm_loadu_ps(obj->vertices[ind[i].idx].pos), c);
+            float d2 = dot3_ps(d, d);
+            if (d2 > r2)
+                r2 = d2;
+        }
+
+        float tmp[4];
+        _mm_storeu_ps(tmp, lo);
+        glm_vec3_copy(tmp, grp->min);
+        _mm_storeu_ps(tmp, hi);
+        glm_vec3_copy(tmp, grp->max);
+        _mm_storeu_ps(tmp, c);
+        glm_vec3_copy(tmp, grp->center);
+#else
+        glm_vec3_copy(obj->vertices[ind[0].idx].pos, grp->min);
+        glm_vec3_copy(grp->min, grp->max);
+        for (int i = 1; i < grp->i_cnt; ++i) {
+            glm_vec3_minv(grp->min, obj->vertices[ind[i].idx].pos, grp->min);
+            glm_vec3_maxv(grp->max, obj->vertices[ind[i].idx].pos, grp->max);
+        }
+        glm_vec3_center(grp->min, grp->max, grp->center);
+        for (int i = 0; i < grp->i_cnt; ++i) {
+            float d2 = glm_vec3_distance2(obj->vertices[ind[i].idx].pos, grp->center);
+            if (d2 > r2)
+                r2 = d2;
+        }
+#endif
+        grp->radius = sqrtf(r2);
+    }
+}
@@ -0,0 +1,679 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <bgl/bglt.h>
+
+#include "internal.h"
+
+
+#define GLB_MAGIC       0x46546C67u     // "glTF"
+#define GLB_CHUNK_JSON  0x4E4F534Au
+#define GLB_CHUNK_BIN   0x004E4942u
+#define GLB_MAX_DEPTH   64
+
+enum {
+    JSON_OBJECT,
+    JSON_ARRAY,
+    JSON_STRING,
+    JSON_PRIMITIVE,
+};
+
+typedef struct {
+    int type;
+    int start;
+    int end;
+    int size;       // direct child tokens, keys and values both count
+    int parent;
+} json_tok;
+
+typedef struct {
+    const char *json;
+    json_tok *t;
+    const unsigned char *bin;
+    size_t bin_size;
+    const char *err;
+} glb_ctx;
+
+typedef struct {
+    const unsigned char *data;
+    const unsigned char *end;   // of the buffer view
+    size_t stride;
+    int comp_type;
+    int comps;
+    int normalized;
+    int count;
+} glb_accessor;
+
+/*!
+ * @brief Tokenize JSON in place, the grammar is checked only as far as nesting goes.
+ */
+static int json_parse(const char *s, int len, json_tok *t, int max) {
+    int n = 0, parent = -1;
+
+    for (int i = 0; i < len; ++i) {
+        int type, j;
+
+        switch (s[i]) {
+        case '{':
+        case '[':
+            if (n == max)
+                return -1;
+            if (parent >= 0)
+                ++t[parent].size;
+            t[n] = (json_tok){s[i] == '{' ? JSON_OBJECT : JSON_ARRAY, i, -1, 0, parent};
+            parent = n++;
+            continue;
+        case '}':
+        case ']':
+            if (parent < 0 || t[parent].type != (s[i] == '}' ? JSON_OBJECT : JSON_ARRAY))
+                return -1;
+            t[parent].end = i + 1;
+            parent = t[parent].parent;
+            continue;
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+        case ':':
+        case ',':
+            continue;
+        case '"':
+            for (j = ++i; j < len && s[j] != '"'; ++j)
+                if (s[j] == '\\')
+                    ++j;
+            if (j >= len)
+                return -1;
+            type = JSON_STRING;
+            break;
+        default:
+            for (j = i; j < len && !strchr(" \t\r\n,:]}", s[j]); ++j);
+            type = JSON_PRIMITIVE;
+            break;
+        }
+
+        if (n == max)
+            return -1;
+        if (parent >= 0)
+            ++t[parent].size;
+        t[n++] = (json_tok){type, i, j, 0, parent};
+        i = type == JSON_STRING ? j : j - 1;
+    }
+
+    return parent < 0 && n ? n : -1;
+}
+
+static int json_skip(const json_tok *t, int i) {
+    for (int n = 1; n--; ++i)
+        n += t[i].size;
+
+    return i;
+}
+
+static int json_get(const glb_ctx *g, int obj, const char *key) {
+    size_t len = strlen(key);
+
+    if (obj < 0 || g->t[obj].type != JSON_OBJECT)
+        return -1;
+
+    for (int k = 0, i = obj + 1; k < g->t[obj].size / 2; ++k, i = json_skip(g->t, i + 1)) {
+        const json_tok *kt = &g->t[i];
+        if (kt->type == JSON_STRING && (size_t)(kt->end - kt->start) == len && !memcmp(&g->json[kt->start], key, len))
+            return i + 1;
+    }
+
+    return -1;
+}
+
+static int json_at(const glb_ctx *g, int arr, int idx) {
+    if (arr < 0 || g->t[arr].type != JSON_ARRAY || idx < 0 || idx >= g->t[arr].size)
+        return -1;
+
+    int i = arr + 1;
+    while (idx--)
+        i = json_skip(g->t, i);
+
+    return i;
+}
+
+static double json_num(const glb_ctx *g, int tok, double def) {
+    char buf[64];
+
+    if (tok < 0 || g->t[tok].type != JSON_PRIMITIVE)
+        return def;
+
+    int len = g->t[tok].end - g->t[tok].start;
+    if (len >= (int)sizeof(buf))
+        return def;
+    memcpy(buf, &g->json[g->t[tok].start], len);
+    buf[len] = '\0';
+
+    char *end;
+    double v = strtod(buf, &end);
+
+    return end == buf ? def : v;
+}
+
+static int json_int(const glb_ctx *g, int tok, int def) {
+    double v = json_num(g, tok, def);
+
+    return v >= INT_MIN && v <= INT_MAX ? (int)v : def;
+}
+
+static char *json_strdup(const glb_ctx *g, int tok) {
+    if (tok < 0 || g->t[tok].type != JSON_STRING)
+        return NULL;
+
+    return bgl_strndup(&g->json[g->t[tok].start], g->t[tok].end - g->t[tok].start);
+}
+
+static int comp_size(int comp_type) {
+    switch (comp_type) {
+    case 5120:  // byte
+    case 5121:  // unsigned byte
+        return 1;
+    case 5122:  // short
+    case 5123:  // unsigned short
+        return 2;
+    case 5125:  // unsigned int
+    case 5126:  // float
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+static int type_comps(const glb_ctx *g, int tok) {
+    static const char *const names[] = {"SCALAR", "VEC2", "VEC3", "VEC4"};
+
+    if (tok < 0 || g->t[tok].type != JSON_STRING)
+        return 0;
+    for (int i = 0; i < 4; ++i)
+        if ((size_t)(g->t[tok].end - g->t[tok].start) == strlen(names[i])
+                && !memcmp(&g->json[g->t[tok].start], names[i], strlen(names[i])))
+            return i + 1;
+
+    return 0;
+}
+
+static int get_accessor(glb_ctx *g, int idx, glb_accessor *acc) {
+    int a = json_at(g, json_get(g, 0, "accessors"), idx);
+    int view = json_at(g, json_get(g, 0, "bufferViews"), json_int(g, json_get(g, a, "bufferView"), -1));
+    int normalized = json_get(g, a, "normalized");
+
+    if (a < 0 || view < 0) {
+        g->err = "invalid accessor";
+        return false;
+    }
+    if (json_get(g, a, "sparse") >= 0 || json_int(g, json_get(g, view, "buffer"), 0) != 0) {
+        g->err = "sparse accessors and external buffers are not supported";
+        return false;
+    }
+
+    *acc = (glb_accessor){
+            .comp_type = json_int(g, json_get(g, a, "componentType"), 0),
+            .comps = type_comps(g, json_get(g, a, "type")),
+            .normalized = normalized >= 0 && g->t[normalized].type == JSON_PRIMITIVE
+                          && g->json[g->t[normalized].start] == 't',
+            .count = json_int(g, json_get(g, a, "count"), -1),
+    };
+
+    double off = json_num(g, json_get(g, view, "byteOffset"), 0) + json_num(g, json_get(g, a, "byteOffset"), 0);
+    double view_end = json_num(g, json_get(g, view, "byteOffset"), 0) + json_num(g, json_get(g, view, "byteLength"), -1);
+    size_t elem = (size_t)comp_size(acc->comp_type) * acc->comps;
+
+    acc->stride = (size_t)json_int(g, json_get(g, view, "byteStride"), 0) ? : elem;
+    if (!elem || acc->count < 0 || off < 0 || view_end > (double)g->bin_size
+            || (acc->count && off + (double)acc->stride * (acc->count - 1) + elem > view_end)) {
+        g->err = "accessor out of bounds";
+        return false;
+    }
+    acc->data = &g->bin[(size_t)off];
+    acc->end = &g->bin[(size_t)view_end];
+
+    return true;
+}
+
+static float acc_float(const glb_accessor *acc, int i, int k) {
+    const unsigned char *p = &acc->data[i * acc->stride + k * comp_size(acc->comp_type)];
+
+    // glTF data is little endian
+    switch (acc->comp_type) {
+    case 5120:
+        return acc->normalized ? glm_max(*(const int8_t *)p / 127.0f, -1.0f) : *(const int8_t *)p;
+    case 5121:
+        return acc->normalized ? *p / 255.0f : *p;
+    case 5122:
+        return acc->normalized ? glm_max((int16_t)bgl_load_u16(p, BGL_BIG_ENDIAN) / 32767.0f, -1.0f)
+                               : (int16_t)bgl_load_u16(p, BGL_BIG_ENDIAN);
+    case 5123:
+        return bgl_load_u16(p, BGL_BIG_ENDIAN) / (acc->normalized ? 65535.0f : 1.0f);
+    case 5125:
+        return (float)bgl_load_u32(p, BGL_BIG_ENDIAN);
+    default:
+        return bgl_load_f32(p, BGL_BIG_ENDIAN);
+    }
+}
+
+static uint32_t acc_index(const glb_accessor *acc, int i) {
+    const unsigned char *p = &acc->data[i * acc->stride];
+
+    switch (acc->comp_type) {
+    case 5121:
+        return *p;
+    case 5123:
+        return bgl_load_u16(p, BGL_BIG_ENDIAN);
+    default:
+        return bgl_load_u32(p, BGL_BIG_ENDIAN);
+    }
+}
+
+/*!
+ * @brief The primitive is used from the mapping when its attributes interleave exactly as `vertex`.
+ */
+static int matches_vertex(const glb_accessor *pos, const glb_accessor *color, const glb_accessor *normal) {
+    const unsigned char *base = pos->data;
+
+    if (BGL_BIG_ENDIAN || !color || !normal || ((uintptr_t)base & 15) || pos->stride != sizeof(vertex))
+        return false;
+    // the last vertex is read whole, past the end of its position
+    if ((size_t)(pos->end - base) / sizeof(vertex) < (size_t)pos->count)
+        return false;
+
+    return pos->comp_type == 5126 && pos->comps == 3
+           && color->comp_type == 5126 && color->comps == 4 && color->data == base + offsetof(vertex, color)
+           && normal->comp_type == 5126 && normal->comps == 3 && normal->data == base + offsetof(vertex, normal)
+           && color->stride == pos->stride && normal->stride == pos->stride
+           && color->count == pos->count && normal->count == pos->count;
+}
+
+static int load_primitive(glb_ctx *g, int prim, bgl_glb_primitive_t *dst) {
+    static const bgl_drawing_modes modes[] = {
+            BGL_POINTS, BGL_LINES, BGL_LINES_LOOP, BGL_LINES_STRIP,
+            BGL_TRIANGLES, BGL_TRIANGLES_STRIP, BGL_TRIANGLES_FAN,
+    };
+    glb_accessor pos, color, normal, ind;
+    int attrs = json_get(g, prim, "attributes");
+    int a_pos = json_get(g, attrs, "POSITION"), a_color = json_get(g, attrs, "COLOR_0");
+    int a_normal = json_get(g, attrs, "NORMAL"), a_ind = json_get(g, prim, "indices");
+    int mode = json_int(g, json_get(g, prim, "mode"), 4);
+
+    if (a_pos < 0 || mode < 0 || mode > 6) {
+        g->err = "invalid primitive";
+        return EINVAL;
+    }
+    if (!get_accessor(g, json_int(g, a_pos, -1), &pos)
+            || (a_color >= 0 && !get_accessor(g, json_int(g, a_color, -1), &color))
+            || (a_normal >= 0 && !get_accessor(g, json_int(g, a_normal, -1), &normal))
+            || (a_ind >= 0 && !get_accessor(g, json_int(g, a_ind, -1), &ind)))
+        return EINVAL;
+    if (pos.comps != 3 || (a_color >= 0 && color.comps < 3) || (a_normal >= 0 && normal.comps != 3)
+            || (a_color >= 0 && color.count < pos.count) || (a_normal >= 0 && normal.count < pos.count)
+            || (a_ind >= 0 && (ind.comps != 1 || ind.comp_type == 5126 || ind.comp_type == 5120 || ind.comp_type == 5122))) {
+        g->err = "unsupported accessor layout";
+        return EINVAL;
+    }
+
+    *dst = (bgl_glb_primitive_t){.v_cnt = pos.count, .mode = modes[mode]};
+
+    if (matches_vertex(&pos, a_color >= 0 ? &color : NULL, a_normal >= 0 ? &normal : NULL)) {
+        dst->vertices = (const vertex *)pos.data;
+    } else {
+        vertex *v = malloc(pos.count * sizeof(*v) + 1);
+        if (!v)
+            return errno;
+        for (int i = 0; i < pos.count; ++i) {
+            v[i] = (vertex){.pos = GLM_VEC4_BLACK_INIT, .color = GLM_VEC4_ONE_INIT};
+            for (int k = 0; k < 3; ++k) {
+                v[i].pos[k] = acc_float(&pos, i, k);
+                if (a_normal >= 0)
+                    v[i].normal[k] = acc_float(&normal, i, k);
+            }
+            for (int k = 0; a_color >= 0 && k < color.comps; ++k)
+                v[i].color[k] = acc_float(&color, i, k);
+        }
+        dst->vertices = v;
+    }
+
+    if (a_ind < 0)
+        return 0;
+
+    // the index buffer carries the corner color and normal, so indices are always converted
+    if (!(dst->indices = malloc(ind.count * sizeof(*dst->indices) + 1)))
+        return errno;
+    for (int i = 0; i < ind.count; ++i) {
+        uint32_t idx = acc_index(&ind, i);
+        if (idx >= (uint32_t)pos.count) {
+            g->err = "index out of range";
+            return EINVAL;
+        }
+        vindex *d = &dst->indices[i];
+        d->idx = (int)idx;
+        glm_vec4_copy((float *)dst->vertices[idx].color, d->color);
+        glm_vec3_copy((float *)dst->vertices[idx].normal, d->normal);
+    }
+    dst->i_cnt = ind.count;
+
+    return 0;
+}
+
+static void node_matrix(const glb_ctx *g, int node, mat4 dst) {
+    int m = json_get(g, node, "matrix");
+
+    if (m >= 0 && g->t[m].size == 16) {
+        for (int i = 0; i < 16; ++i)
+            dst[i / 4][i % 4] = (float)json_num(g, json_at(g, m, i), i % 5 ? 0 : 1);
+        return;
+    }
+
+    vec3 t, s;
+    versor q;
+    mat4 r;
+    int tt = json_get(g, node, "translation"), rt = json_get(g, node, "rotation"), st = json_get(g, node, "scale");
+
+    for (int k = 0; k < 3; ++k) {
+        t[k] = (float)json_num(g, json_at(g, tt, k), 0);
+        s[k] = (float)json_num(g, json_at(g, st, k), 1);
+    }
+    for (int k = 0; k < 4; ++k)
+        q[k] = (float)json_num(g, json_at(g, rt, k), k == 3 ? 1 : 0);
+
+    // T * R * S
+    glm_translate_make(dst, t);
+    glm_quat_mat4(q, r);
+    glm_mat4_mul(dst, r, dst);
+    glm_scale(dst, s);
+}
+
+static int count_nodes(const glb_ctx *g, int node, int depth, char *seen) {
+    int idx = node, cnt = 0;
+
+    node = json_at(g, json_get(g, 0, "nodes"), idx);
+    if (node < 0 || depth > GLB_MAX_DEPTH || seen[idx])
+        return 0;
+    seen[idx] = 1;
+
+    cnt += json_get(g, node, "mesh") >= 0;
+    int children = json_get(g, node, "children");
+    for (int i = 0; children >= 0 && i < g->t[children].size; ++i)
+        cnt += count_nodes(g, json_int(g, json_at(g, children, i), -1), depth + 1, seen);
+
+    return cnt;
+}
+
+static void collect_nodes(const glb_ctx *g, bgl_glb_t *glb, int node, mat4 parent, int depth, char *seen) {
+    int idx = node;
+    mat4 world;
+
+    node = json_at(g, json_get(g, 0, "nodes"), idx);
+    if (node < 0 || depth > GLB_MAX_DEPTH || seen[idx])
+        return;
+    seen[idx] = 1;
+
+    node_matrix(g, node, world);
+    glm_mat4_mul(parent, world, world);
+
+    int mesh = json_int(g, json_get(g, node, "mesh"), -1);
+    if (mesh >= 0 && mesh < glb->mesh_cnt) {
+        bgl_glb_node_t *n = &glb->nodes[glb->node_cnt++];
+        glm_mat4_copy(world, n->model);
+        n->name = json_strdup(g, json_get(g, node, "name"));
+        n->mesh = mesh;
+        glb->buffer_cnt += glb->meshes[mesh].prim_cnt;
+    }
+
+    int children = json_get(g, node, "children");
+    for (int i = 0; children >= 0 && i < g->t[children].size; ++i)
+        collect_nodes(g, glb, json_int(g, json_at(g, children, i), -1), world, depth + 1, seen);
+}
+
+/*!
+ * @brief Scene roots: the default scene, else every node nobody lists as a child.
+ */
+static int scene_roots(const glb_ctx *g, int *roots, int node_cnt) {
+    int scene = json_at(g, json_get(g, 0, "scenes"), json_int(g, json_get(g, 0, "scene"), 0));
+    int list = json_get(g, scene, "nodes"), cnt = 0;
+
+    if (list >= 0) {
+        for (int i = 0; i < g->t[list].size && cnt < node_cnt; ++i)
+            roots[cnt++] = json_int(g, json_at(g, list, i), -1);
+        return cnt;
+    }
+
+    char *child = calloc(node_cnt + 1, 1);
+    if (!child)
+        return -1;
+    int nodes = json_get(g, 0, "nodes");
+    for (int i = 0; i < node_cnt; ++i) {
+        int children = json_get(g, json_at(g, nodes, i), "children");
+        for (int k = 0; children >= 0 && k < g->t[children].size; ++k) {
+            int c = json_int(g, json_at(g, children, k), -1);
+            if (c >= 0 && c < node_cnt)
+                child[c] = 1;
+        }
+    }
+    for (int i = 0; i < node_cnt; ++i)
+        if (!child[i])
+            roots[cnt++] = i;
+    free(child);
+
+    return cnt;
+}
+
+static int load_scene(glb_ctx *g, bgl_glb_t *glb) {
+    int meshes = json_get(g, 0, "meshes"), nodes = json_get(g, 0, "nodes");
+    int node_cnt = nodes >= 0 ? g->t[nodes].size : 0;
+    int err = 0, *roots = NULL, root_cnt;
+    char *seen = NULL;
+    mat4 identity = GLM_MAT4_IDENTITY_INIT;
+
+    glb->mesh_cnt = meshes >= 0 ? g->t[meshes].size : 0;
+    if (!(glb->meshes = calloc(glb->mesh_cnt + 1, sizeof(*glb->meshes))))
+        return errno;
+
+    for (int i = 0; i < glb->mesh_cnt; ++i) {
+        int mesh = json_at(g, meshes, i), prims = json_get(g, mesh, "primitives");
+        bgl_glb_mesh_t *m = &glb->meshes[i];
+
+        m->name = json_strdup(g, json_get(g, mesh, "name"));
+        if (prims < 0)
+            continue;
+        if (!(m->primitives = calloc(g->t[prims].size + 1, sizeof(*m->primitives))))
+            return errno;
+        m->prim_cnt = g->t[prims].size;
+        for (int k = 0; k < m->prim_cnt; ++k)
+            if ((err = load_primitive(g, json_at(g, prims, k), &m->primitives[k])))
+                return err;
+    }
+
+    if (!((roots = malloc((node_cnt + 1) * sizeof(*roots))) && (seen = calloc(node_cnt + 1, 1)))) {
+        err = errno;
+        goto end;
+    }
+    if ((root_cnt = scene_roots(g, roots, node_cnt)) < 0) {
+        err = errno;
+        goto end;
+    }
+
+    int inst = 0;
+    for (int i = 0; i < root_cnt; ++i)
+        inst += count_nodes(g, roots[i], 0, seen);
+    memset(seen, 0, node_cnt + 1);
+
+    // model matrices may need 32 bytes alignment
+    if (!(glb->nodes = bgl_aligned_alloc(32, ((inst + 1) * sizeof(*glb->nodes) + 31) & ~(size_t)31))) {
+        err = errno;
+        goto end;
+    }
+    for (int i = 0; i < root_cnt; ++i)
+        collect_nodes(g, glb, roots[i], identity, 0, seen);
+
+end:
+    free(roots);
+    free(seen);
+
+    return err;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BGL_API bgl_glb_t *bgl_load_glb(const char *path) {
+    glb_ctx g = {0};
+    bgl_glb_t *glb = NULL;
+    const unsigned char *data;
+    size_t size;
+    int err = 0;
+
+    if (!(data = map_platform_file(path, &size)))
+        return NULL;
+
+    // header, JSON chunk, optional BIN chunk
+    uint32_t json_len = size >= 20 ? bgl_load_u32(&data[12], BGL_BIG_ENDIAN) : 0;
+    if (size < 20 || bgl_load_u32(data, BGL_BIG_ENDIAN) != GLB_MAGIC || bgl_load_u32(&data[4], BGL_BIG_ENDIAN) != 2
+            || bgl_load_u32(&data[16], BGL_BIG_ENDIAN) != GLB_CHUNK_JSON
+            || json_len > size - 20 || json_len > INT_MAX / 2) {
+        g.err = "not a glTF 2.0 binary";
+        goto end;
+    }
+    g.json = (const char *)&data[20];
+
+    size_t bin = 20 + ((json_len + 3) & ~3u);
+    if (bin + 8 <= size && bgl_load_u32(&data[bin + 4], BGL_BIG_ENDIAN) == GLB_CHUNK_BIN) {
+        g.bin_size = bgl_load_u32(&data[bin], BGL_BIG_ENDIAN);
+        g.bin = &data[bin + 8];
+        if (g.bin_size > size - bin - 8) {
+            g.err = "truncated BIN chunk";
+            goto end;
+        }
+    }
+
+    int max = (int)json_len / 2 + 2;
+    if (!(g.t = malloc(max * sizeof(*g.t)))) {
+        err = errno;
+        goto end;
+    }
+    if (json_parse(g.json, (int)json_len, g.t, max) < 0 || g.t[0].type != JSON_OBJECT) {
+        g.err = "malformed JSON";
+        goto end;
+    }
+
+    if (!(glb = calloc(1, sizeof(*glb)))) {
+        err = errno;
+        goto end;
+    }
+    glb->map = (void *)data;
+    glb->map_size = size;
+
+    err = load_scene(&g, glb);
+
+end:
+    free(g.t);
+
+    if (g.err || err) {
+        if (g.err)
+            err = EINVAL;
+        fprintf(stderr, "Failed to load GLB: %s: %s\n", path, g.err ? : strerror(err));
+        if (glb)
+            bgl_destroy_glb(glb);
+        else
+            unmap_platform_file((void *)data, size);
+        glb = NULL;
+    }
+    errno = err;
+
+    return glb;
+}
+
+/*!
+ * @brief Remove the first n buffers made by bgl_create_glb_buffers, walking the primitives in the same order.
+ */
+static void remove_glb_buffers(bgl_instance bgl, bgl_glb_t *glb, const int *made, int n) {
+    for (int i = 0, j = 0; i < glb->node_cnt && j < n; ++i) {
+        bgl_glb_mesh_t *mesh = &glb->meshes[glb->nodes[i].mesh];
+
+        for (int k = 0; k < mesh->prim_cnt && j < n; ++k, ++j) {
+            if (mesh->primitives[k].indices)
+                bgl_remove_index_buffer(bgl, made[j], true);
+            else
+                bgl_remove_vertex_buffer(bgl, made[j]);
+        }
+    }
+}
+
+BGL_API int bgl_create_glb_buffers(bgl_instance bgl, bgl_glb_t *glb, int *ids) {
+    int n = 0, total = 0, *made = ids;
+
+    // the buffers made so far are removed when a primitive fails
+    for (int i = 0; i < glb->node_cnt; ++i)
+        total += glb->meshes[glb->nodes[i].mesh].prim_cnt;
+    if (!made && !(made = malloc((total + 1) * sizeof(*made)))) {
+        fprintf(stderr, "Failed to create GLB buffers: %s\n", strerror(errno));
+        return false;
+    }
+
+    for (int i = 0; i < glb->node_cnt; ++i) {
+        bgl_glb_node_t *node = &glb->nodes[i];
+        bgl_glb_mesh_t *mesh = &glb->meshes[node->mesh];
+
+        for (int k = 0; k < mesh->prim_cnt; ++k) {
+            bgl_glb_primitive_t *p = &mesh->primitives[k];
+            int vbuf = bgl_create_vertex_buffer(bgl, p->vertices, p->v_cnt, p->mode), id = vbuf;
+
+            if (vbuf < 0)
+                goto fail;
+            bgl_bind_model_matrix(bgl, vbuf, &node->model);
+
+            if (p->indices && (id = bgl_create_index_buffer(bgl, vbuf, p->indices, p->i_cnt, p->mode)) < 0) {
+                bgl_remove_vertex_buffer(bgl, vbuf);
+                goto fail;
+            }
+            made[n++] = id;
+        }
+    }
+
+    if (made != ids)
+        free(made);
+
+    return true;
+
+fail:
+    remove_glb_buffers(bgl, glb, made, n);
+    if (made != ids)
+        free(made);
+
+    return false;
+}
+
+BGL_API void bgl_destroy_glb(bgl_glb_t *glb) {
+    const char *map = glb->map;
+
+    for (int i = 0; i < glb->mesh_cnt; ++i) {
+        bgl_glb_mesh_t *m = &glb->meshes[i];
+        for (int k = 0; k < m->prim_cnt; ++k) {
+            const char *v = (const char *)m->primitives[k].vertices;
+            if (!(v >= map && v < map + glb->map_size))
+                free((void *)v);
+            free(m->primitives[k].indices);
+        }
+        free(m->primitives);
+        free(m->name);
+    }
+    free(glb->meshes);
+
+    for (int i = 0; i < glb->node_cnt; ++i)
+        free(glb->nodes[i].name);
+    if (glb->nodes)
+        bgl_aligned_free(glb->nodes);
+
+    unmap_platform_file(glb->map, glb->map_size);
+    free(glb);
+}
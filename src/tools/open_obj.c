@@ -6,6 +6,8 @@
  */
 
 #include <errno.h>
+#include <limits.h>
+#include <math.h>
 #include <string.h>
 
 #include <bgl/bglt.h>
@@ -23,10 +25,10 @@ typedef struct {
 
 #define BUF_PUSH_BACK(bb, type, data)                                               \
     ({                                                                              \
-        if ((bb.cnt >= bb.buf_sz || !bb.buf)                                        \
-                && !(bb.buf = bgl_realloc_array(bb.buf, bb.buf_sz <<= 1, sizeof(type))))    \
-            NULL;                                                                   \
-        memcpy(&((type *)bb.buf)[bb.cnt++], &data, sizeof(type));                   \
+        type *_p = NULL;                                                            \
+        if (buf_reserve(&(bb), 1, sizeof(type)))                                    \
+            memcpy(_p = &((type *)(bb).buf)[(bb).cnt++], &(data), sizeof(type));    \
+        _p;                                                                         \
     })
 
 #define GROUP_INIT      \
@@ -38,13 +40,148 @@ typedef struct {
             cur_grp = &((bgl_obj_group_t*)groups.buf)[groups.cnt - 1];  \
         }
 
-static int parse_float(char *s, float v[6]) {
+#define IS_SPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\r')
+#define IS_DIGIT(c) ((unsigned)((c) - '0') < 10)
+
+static int buf_reserve(obuf_t *bb, int n, size_t size) {
+    if (bb->cnt + n <= bb->buf_sz && bb->buf)
+        return true;
+
+    int sz = bb->buf ? bb->buf_sz << 1 : bb->buf_sz ? : 16;
+    while (sz < bb->cnt + n)
+        sz <<= 1;
+    void *p = bgl_realloc_array(bb->buf, sz, size);
+    if (!p)
+        return false;
+
+    bb->buf = p;
+    bb->buf_sz = sz;
+
+    return true;
+}
+
+static const char *skip_space(const char *s, const char *end) {
+    while (s < end && IS_SPACE(*s))
+        ++s;
+    return s;
+}
+
+static const double pow10_tab[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/*!
+ * @brief Locale independent float parser, the mantissa keeps 18 significant digits.
+ * @return the end of the number or NULL if there are no digits
+ */
+static const char *parse_float(const char *s, const char *end, float *v) {
+    uint64_t mant = 0;
+    int exp = 0, digits = 0, neg = 0;
+
+    if (s < end && (*s == '-' || *s == '+'))
+        neg = *s++ == '-';
+
+    for (; s < end && IS_DIGIT(*s); ++s, ++digits) {
+        if (mant < 100000000000000000ull)
+            mant = mant * 10 + (*s - '0');
+        else
+            ++exp;
+    }
+    if (s < end && *s == '.') {
+        for (++s; s < end && IS_DIGIT(*s); ++s, ++digits) {
+            if (mant < 100000000000000000ull) {
+                mant = mant * 10 + (*s - '0');
+                --exp;
+            }
+        }
+    }
+    if (!digits)
+        return NULL;
+
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        const char *e = s + 1;
+        int e_neg = 0, e_val = 0;
+
+        if (e < end && (*e == '-' || *e == '+'))
+            e_neg = *e++ == '-';
+        if (e < end && IS_DIGIT(*e)) {
+            for (; e < end && IS_DIGIT(*e); ++e)
+                if (e_val < 10000)
+                    e_val = e_val * 10 + (*e - '0');
+            exp += e_neg ? -e_val : e_val;
+            s = e;
+        }
+    }
+
+    double d = (double)mant;
+    if (exp < 0)
+        d = exp >= -22 ? d / pow10_tab[-exp] : d * pow(10, exp);
+    else if (exp > 0)
+        d = exp <= 22 ? d * pow10_tab[exp] : d * pow(10, exp);
+    *v = (float)(neg ? -d : d);
+
+    return s;
+}
+
+static const char *parse_int(const char *s, const char *end, int *v) {
+    const char *start;
+    int64_t x = 0;
+    int neg = 0;
+
+    if (s < end && (*s == '-' || *s == '+'))
+        neg = *s++ == '-';
+
+    for (start = s; s < end && IS_DIGIT(*s); ++s)
+        if (x <= INT_MAX)
+            x = x * 10 + (*s - '0');
+    if (s == start)
+        return NULL;
+
+    x = x > INT_MAX ? INT_MAX : x;
+    *v = (int)(neg ? -x : x);
+
+    return s;
+}
+
+static int parse_floats(const char *s, const char *end, float v[6]) {
     int cnt = 0;
-    while ((s = strchr(s, ' ')))
-        v[cnt++] = strtof(++s, &s);
+
+    while (cnt < 6 && (s = skip_space(s, end)) < end && (s = parse_float(s, end, &v[cnt])))
+        ++cnt;
+
     return cnt;
 }
 
+static int parse_vertex(const char *s, const char *end, vertex *vtx) {
+    float vval[6];
+
+    *vtx = (vertex){.pos = GLM_VEC4_BLACK_INIT, .color = GLM_VEC4_ONE_INIT};
+
+    switch (parse_floats(s, end, vval)) {
+    case 4:
+        vtx->pos[3] = vval[3];
+    case 3:
+        glm_vec3_copy(vval, vtx->pos);
+        return true;
+    case 6:
+        glm_vec3_copy(vval, vtx->pos);
+        glm_vec3_copy(&vval[3], vtx->color);
+        return true;
+    default:
+        return false;
+    }
+}
+
+static const char *parse_name(const char *s, const char *end, const char **name_end) {
+    s = skip_space(s, end);
+    while (end > s && IS_SPACE(end[-1]))
+        --end;
+    *name_end = end;
+
+    return s;
+}
+
 typedef union {
     int v[3];
     struct {
@@ -52,176 +189,915 @@ typedef union {
     };
 } oface_t;
 
-static int parse_face(char *s, oface_t face[3]) {
-    char tmp_buf[512];
-    int cnt = 0;
-    int i;
-    memset(face, 0, sizeof(oface_t) * 3);
-    s = strchr(s, ' ');
-    while (s) {
-        i = 0;
-        face[cnt].v[i++] = (int)strtoull(++s, &s, 10);
-
-        char *t = strchr(s, ' ');
-        ssize_t n = t ? t - s : (ssize_t)sizeof(tmp_buf) - 1;
-        strncpy(tmp_buf, s, n);
-        tmp_buf[n] = '\0';
-        s = t;
-        t = tmp_buf;
-        while (i < 3 && (t = strchr(t, '/'))) {
-            int x = (int)strtoull(++t, &t, 10);
-            if (x)
-                face[cnt].v[i] = x;
-            ++i;
-        }
-        ++cnt;
+/*!
+ * @brief Parse `v`, `v/vt`, `v//vn` or `v/vt/vn` corners, zero marks an absent index.
+ * @return the number of corners stored in `face` or -1 on allocation failure
+ */
+static int parse_face(const char *s, const char *end, obuf_t *face) {
+    face->cnt = 0;
+    while ((s = skip_space(s, end)) < end && *s != '#') {
+        oface_t c = {0};
+
+        if (!(s = parse_int(s, end, &c.vi)))
+            break;
+        for (int i = 1; i < 3 && s < end && *s == '/'; ++i)
+            if (++s < end && *s != '/' && !IS_SPACE(*s) && !(s = parse_int(s, end, &c.v[i])))
+                return 0;
+
+        if (!BUF_PUSH_BACK(*face, oface_t, c))
+            return -1;
     }
-    return cnt;
+
+    return face->cnt;
 }
 
-BGL_API bgl_obj_t *bgl_load_obj(const char *path) {
-    FILE *obj_f = NULL;
-    char *buf = NULL;
-    size_t buf_sz = 512;
-    int err = 0;
+#define CORNER_V_REL    0x1     // v is relative to the chunk start
+#define CORNER_VN_REL   0x2     // vn is relative to the chunk start
+#define CORNER_VN       0x4     // vn is present
+#define CORNER_POLY_SHIFT   3   // the first corner of a polygon holds its size
 
-    if (!(obj_f = fopen(path, "r")))
-        return NULL;
+#define OBJ_MIN_CHUNK   (1 << 20)
 
-    if (!(buf = malloc(buf_sz))) {
-        err = errno;
-        goto end;
+typedef struct {
+    int v, vn;
+    int flags;
+} ocorner_t;
+
+typedef struct {
+    char *name;
+    int first;      // first triangle corner of the group in the chunk
+} ogroup_t;
+
+/*!
+ * @brief Part of a mapped file split at a line boundary, parsed independently.
+ * Absolute indices are stored 0-based, relative ones against the chunk counters.
+ */
+typedef struct {
+    const char *begin, *end;
+    obuf_t v, vn, f, groups;
+    int tri_cnt;        // corners after triangulation
+    int lead_faces;     // faces before the first `o` continue the previous group
+    int err;
+
+    obuf_t face, poly, ear;     // scratch
+
+    // stitching
+    int v_off, vn_off, v_total;
+    int *seg_grp, *seg_off;
+    vertex *positions;
+    vec3 *normals;
+    bgl_obj_group_t *out_groups;
+} obj_chunk_t;
+
+static void chunk_push_group(obj_chunk_t *c, const char *name, const char *name_end) {
+    ogroup_t g = {bgl_strndup(name, name_end - name), c->tri_cnt};
+
+    if (!g.name || !BUF_PUSH_BACK(c->groups, ogroup_t, g)) {
+        free(g.name);
+        c->err = errno;
     }
+}
 
-    obuf_t groups = BUFFER_INIT;
-    obuf_t v = BUFFER_INIT;
-    obuf_t vn = BUFFER_INIT;
-    obuf_t f = BUFFER_INIT;
-    bgl_obj_group_t *cur_grp = NULL;
+static void parse_chunk(void *arg) {
+    obj_chunk_t *c = arg;
+    const char *s, *eol;
 
     float vval[6];
-    oface_t fval[3];
     vertex vtx;
     vec3 normal;
 
-    errno = 0;
-    ssize_t n;
-    while ((n = bgl_getline(&buf, &buf_sz, obj_f)) >= 0) {
-        switch (*buf) {
+    // tokens are parsed in place
+    for (s = c->begin; s < c->end && !c->err; s = eol + 1) {
+        if (!(eol = memchr(s, '\n', c->end - s)))
+            eol = c->end;
+        s = skip_space(s, eol);
+        if (eol - s < 2)
+            continue;
+
+        switch (*s) {
         case 'o':   // object name
-            if (groups.cnt) {
-                if (f.cnt) {
-                    cur_grp->i_cnt = f.cnt;
-                    cur_grp->indices = bgl_realloc_array(f.buf, f.cnt, sizeof(*cur_grp->indices));
-                    f.buf = NULL;
-                    f.cnt = 0;
-                }
-            }
-            GROUP_INIT
-            cur_grp->name = bgl_strndup(&buf[2], n - 3);
+            if (!IS_SPACE(s[1]))
+                break;
+            const char *name_end, *name = parse_name(&s[2], eol, &name_end);
+            chunk_push_group(c, name, name_end);
             break;
         case 'v':   // vertex data
-            switch (buf[1]) {
+            switch (s[1]) {
             case ' ':   // geometric vertices
-                vtx = (vertex){.pos = GLM_VEC4_BLACK_INIT, .color = GLM_VEC4_ONE_INIT};
-
-                switch (parse_float(&buf[1], vval)) {
-                case 4:
-                    vtx.pos[3] = vval[3];
-                case 3:
-                    glm_vec3_copy(vval, vtx.pos);
-                    BUF_PUSH_BACK(v, vertex, vtx);
-                    break;
-                case 6:
-                    glm_vec3_copy(vval, vtx.pos);
-                    glm_vec3_copy(&vval[3], vtx.color);
-                    BUF_PUSH_BACK(v, vertex, vtx);
-                default:
-                    break;
-                }
+            case '\t':
+                if (parse_vertex(&s[2], eol, &vtx) && !BUF_PUSH_BACK(c->v, vertex, vtx))
+                    c->err = errno;
                 break;
 
             case 'n':   // vertex normal
-                if (parse_float(&buf[1], vval) == 3) {
+                if (parse_floats(&s[2], eol, vval) == 3) {
                     glm_vec3_copy(vval, normal);
-                    BUF_PUSH_BACK(vn, vec3, normal);
+                    if (!BUF_PUSH_BACK(c->vn, vec3, normal))
+                        c->err = errno;
                 }
                 break;
 
             }
             break;
         case 'f':   // face
-            if (!groups.cnt)
-                GROUP_INIT
-            if (parse_face(buf, fval) == 3) {
-                vindex idx = {0};
-                for (int i = 0; i < 3; ++i) {
-                    idx.idx = fval[i].vi - 1;
-                    glm_vec4_copy(GLM_VEC4_ONE, idx.color);
-                    if (fval[i].vni)
-                        glm_vec3_copy(((vec3 *)vn.buf)[fval[i].vni - 1], idx.normal);
-//                    else
-//                        glm_vec3_copy((vec3){NAN, NAN, NAN}, idx.normal);
-                    BUF_PUSH_BACK(f, vindex, idx);
+            if (!IS_SPACE(s[1]))
+                break;
+            if (!c->groups.cnt)
+                c->lead_faces = true;
+            int n = parse_face(&s[2], eol, &c->face);
+            oface_t *fval = c->face.buf;
+            if (n < 0) {
+                c->err = errno;
+                break;
+            }
+            if (n < 3)
+                break;
+            if (!buf_reserve(&c->f, n, sizeof(ocorner_t))) {
+                c->err = errno;
+                break;
+            }
+            for (int i = 0; i < n; ++i) {
+                ocorner_t cr = {.flags = i ? 0 : n << CORNER_POLY_SHIFT};
+
+                // negative indices are relative to the end of the current list
+                if (fval[i].vi < 0) {
+                    cr.v = c->v.cnt + fval[i].vi;
+                    cr.flags |= CORNER_V_REL;
+                } else {
+                    cr.v = fval[i].vi - 1;
+                }
+                if (fval[i].vni < 0) {
+                    cr.vn = c->vn.cnt + fval[i].vni;
+                    cr.flags |= CORNER_VN | CORNER_VN_REL;
+                } else if (fval[i].vni) {
+                    cr.vn = fval[i].vni - 1;
+                    cr.flags |= CORNER_VN;
                 }
+                ((ocorner_t *)c->f.buf)[c->f.cnt++] = cr;
             }
+            c->tri_cnt += 3 * (n - 2);
             break;
         }
     }
-    if (n == -1 && errno) {
+}
+
+static int polygon_valid(const vindex *poly, int n, int v_cnt) {
+    for (int i = 0; i < n; ++i)
+        if ((unsigned)poly[i].idx >= (unsigned)v_cnt)
+            return false;
+    return true;
+}
+
+static int polygon_convex(const vindex *poly, int n, const vertex *pos, const vec3 normal) {
+    vec3 e0, e1, x;
+
+    for (int i = 0; i < n; ++i) {
+        glm_vec3_sub((float *)pos[poly[(i + 1) % n].idx].pos, (float *)pos[poly[i].idx].pos, e0);
+        glm_vec3_sub((float *)pos[poly[(i + 2) % n].idx].pos, (float *)pos[poly[(i + 1) % n].idx].pos, e1);
+        glm_vec3_cross(e0, e1, x);
+        if (glm_vec3_dot(x, (float *)normal) < 0)
+            return false;
+    }
+
+    return true;
+}
+
+typedef struct {
+    float x, y;
+    int i;
+} ear_pt;
+
+static float ear_cross(const ear_pt *a, const ear_pt *b, const ear_pt *c) {
+    return (b->x - a->x) * (c->y - a->y) - (b->y - a->y) * (c->x - a->x);
+}
+
+static int ear_same(const ear_pt *a, const ear_pt *b) {
+    return a->x == b->x && a->y == b->y;
+}
+
+static int is_ear(const ear_pt *pts, int m, int a, int b, int c) {
+    if (ear_cross(&pts[a], &pts[b], &pts[c]) <= 0)
+        return false;
+
+    // a corner on the boundary blocks the ear too, unless it repeats one of its corners
+    for (int k = 0; k < m; ++k) {
+        if (k == a || k == b || k == c || ear_same(&pts[k], &pts[a]) || ear_same(&pts[k], &pts[b])
+                || ear_same(&pts[k], &pts[c]))
+            continue;
+        if (ear_cross(&pts[a], &pts[b], &pts[k]) >= 0 && ear_cross(&pts[b], &pts[c], &pts[k]) >= 0
+                && ear_cross(&pts[c], &pts[a], &pts[k]) >= 0)
+            return false;
+    }
+
+    return true;
+}
+
+/*!
+ * @brief Split a polygon into n - 2 triangles keeping its winding.
+ * Convex polygons are fanned from the first corner, so consecutive triangles share an edge;
+ * concave ones are ear clipped in the plane of the Newell normal.
+ * @return the number of corners written to dst or -1 on allocation failure
+ */
+static int triangulate(const vindex *poly, int n, const vertex *pos, int v_cnt, obuf_t *ear, vindex *dst) {
+    vindex *d = dst;
+    vec3 normal = {0};
+
+    if (n > 3 && polygon_valid(poly, n, v_cnt)) {
+        for (int i = 0; i < n; ++i) {
+            const float *a = pos[poly[i].idx].pos, *b = pos[poly[(i + 1) % n].idx].pos;
+            normal[0] += (a[1] - b[1]) * (a[2] + b[2]);
+            normal[1] += (a[2] - b[2]) * (a[0] + b[0]);
+            normal[2] += (a[0] - b[0]) * (a[1] + b[1]);
+        }
+    }
+
+    if (n == 3 || glm_vec3_norm2(normal) == 0 || polygon_convex(poly, n, pos, normal)) {
+        for (int i = 1; i < n - 1; ++i) {
+            *d++ = poly[0];
+            *d++ = poly[i];
+            *d++ = poly[i + 1];
+        }
+        return (int)(d - dst);
+    }
+
+    // project onto the plane of the largest normal component, keeping the orientation
+    int ax = fabsf(normal[0]) > fabsf(normal[1]) ? 0 : 1;
+    ax = fabsf(normal[2]) > fabsf(normal[ax]) ? 2 : ax;
+    int u = (ax + 1) % 3, v = (ax + 2) % 3;
+    if (normal[ax] < 0) {
+        int t = u;
+        u = v;
+        v = t;
+    }
+
+    ear->cnt = 0;
+    if (!buf_reserve(ear, n, sizeof(ear_pt)))
+        return -1;
+
+    ear_pt *pts = ear->buf;
+    for (int i = 0; i < n; ++i)
+        pts[i] = (ear_pt){pos[poly[i].idx].pos[u], pos[poly[i].idx].pos[v], i};
+
+    for (int m = n, i = 0, miss = 0; m > 2;) {
+        int a = (i + m - 1) % m, b = i, c = (i + 1) % m;
+
+        // a degenerate remainder has no ear, clip it anyway
+        if (m == 3 || is_ear(pts, m, a, b, c) || ++miss >= m) {
+            *d++ = poly[pts[a].i];
+            *d++ = poly[pts[b].i];
+            *d++ = poly[pts[c].i];
+            memmove(&pts[b], &pts[b + 1], (--m - b) * sizeof(*pts));
+            miss = 0;
+            if (i >= m)
+                i = 0;
+        } else {
+            i = c;
+        }
+    }
+
+    return (int)(d - dst);
+}
+
+static void fill_chunk(void *arg) {
+    obj_chunk_t *c = arg;
+    ocorner_t *cr = c->f.buf;
+    ogroup_t *groups = c->groups.buf;
+    vec3 *normals = c->normals;
+    int vn_cnt = c->vn_off + c->vn.cnt;   // normals visible to this chunk
+    int v_cnt = c->v_total;
+    int sg = 0, out = 0;
+
+    for (int p = 0, n; p < c->f.cnt; p += n) {
+        n = cr[p].flags >> CORNER_POLY_SHIFT;
+
+        while (sg < c->groups.cnt && out >= groups[sg].first)
+            ++sg;
+
+        c->poly.cnt = 0;
+        if (!buf_reserve(&c->poly, n, sizeof(vindex))) {
+            c->err = errno;
+            return;
+        }
+
+        vindex *poly = c->poly.buf;
+        for (int i = 0; i < n; ++i) {
+            const ocorner_t *k = &cr[p + i];
+            int vn = k->vn + (k->flags & CORNER_VN_REL ? c->vn_off : 0);
+
+            poly[i].idx = k->v + (k->flags & CORNER_V_REL ? c->v_off : 0);
+            glm_vec4_copy(GLM_VEC4_ONE, poly[i].color);
+            if (k->flags & CORNER_VN && vn >= 0 && vn < vn_cnt)
+                glm_vec3_copy(normals[vn], poly[i].normal);
+            else
+                glm_vec3_zero(poly[i].normal);
+        }
+
+        int seg_first = sg ? groups[sg - 1].first : 0;
+        vindex *dst = &c->out_groups[c->seg_grp[sg]].indices[c->seg_off[sg] + out - seg_first];
+        int written = triangulate(poly, n, c->positions, v_cnt, &c->ear, dst);
+        if (written < 0) {
+            c->err = errno;
+            return;
+        }
+        out += written;
+    }
+}
+
+static void free_chunk(obj_chunk_t *c) {
+    for (ogroup_t *g = c->groups.buf; c->groups.cnt--; ++g)
+        free(g->name);
+    free(c->groups.buf);
+    free(c->v.buf);
+    free(c->vn.buf);
+    free(c->f.buf);
+    free(c->face.buf);
+    free(c->poly.buf);
+    free(c->ear.buf);
+    free(c->seg_grp);
+    free(c->seg_off);
+}
+
+static void run_chunks(void (*fn)(void *arg), obj_chunk_t *chunks, int cnt) {
+    bgl_platform_thread threads[cnt];
+    int started[cnt];
+
+    for (int i = 1; i < cnt; ++i)
+        started[i] = create_platform_thread(&threads[i], fn, &chunks[i]);
+
+    fn(&chunks[0]);
+
+    // chunks without a worker are run on the calling thread
+    for (int i = 1; i < cnt; ++i) {
+        if (started[i])
+            join_platform_thread(threads[i]);
+        else
+            fn(&chunks[i]);
+    }
+}
+
+/*!
+ * @brief Map global groups onto the chunk segments and size the group index arrays.
+ * Group order matches the serial loader: the last group of the file comes first.
+ */
+static bgl_obj_t *stitch_chunks(obj_chunk_t *chunks, int cnt) {
+    obuf_t groups = BUFFER_INIT;
+    bgl_obj_group_t *cur_grp = NULL;
+    bgl_obj_t *result = NULL;
+    int v_cnt = 0, vn_cnt = 0;
+    int err = 0;
+
+    for (obj_chunk_t *c = chunks; c < &chunks[cnt]; ++c) {
+        ogroup_t *cg = c->groups.buf;
+
+        c->v_off = v_cnt;
+        c->vn_off = vn_cnt;
+        v_cnt += c->v.cnt;
+        vn_cnt += c->vn.cnt;
+
+        if (!((c->seg_grp = malloc((c->groups.cnt + 1) * sizeof(int)))
+                && (c->seg_off = malloc((c->groups.cnt + 1) * sizeof(int))))) {
+            err = errno;
+            goto end;
+        }
+
+        for (int sg = 0; sg <= c->groups.cnt; ++sg) {
+            int first = sg ? cg[sg - 1].first : 0;
+            int last = sg < c->groups.cnt ? cg[sg].first : c->tri_cnt;
+
+            if (sg || (!groups.cnt && c->lead_faces)) {
+                GROUP_INIT
+                if (sg) {
+                    cur_grp->name = cg[sg - 1].name;
+                    cg[sg - 1].name = NULL;
+                }
+            }
+            c->seg_grp[sg] = groups.cnt - 1;
+            c->seg_off[sg] = cur_grp ? cur_grp->i_cnt : 0;
+            if (cur_grp)
+                cur_grp->i_cnt += last - first;
+        }
+    }
+
+    if (!((result = calloc(1, sizeof(*result)))
+            && (result->groups = calloc(groups.cnt + 1, sizeof(*result->groups))))) {
         err = errno;
         goto end;
     }
 
-    if (groups.cnt) {
-        if (f.cnt) {
-            cur_grp->i_cnt = f.cnt;
-            cur_grp->indices = bgl_realloc_array(f.buf, f.cnt, sizeof(*cur_grp->indices));
-            f.buf = NULL;
-            f.cnt = 0;
+    result->v_cnt = v_cnt;      // positions until the corners are deduplicated
+    result->group_cnt = groups.cnt;
+    for (int i = 0; i < groups.cnt; ++i) {
+        bgl_obj_group_t *grp = &result->groups[groups.cnt - 1 - i];
+        bgl_obj_group_t *bb = &((bgl_obj_group_t *)groups.buf)[i];
+
+        grp->name = bb->name;
+        bb->name = NULL;
+        if ((grp->i_cnt = bb->i_cnt) && !(grp->indices = malloc(grp->i_cnt * sizeof(*grp->indices)))) {
+            err = errno;
+            goto end;
         }
     }
 
+    for (int i = 0; i < cnt; ++i) {
+        for (int sg = 0; sg <= chunks[i].groups.cnt; ++sg)
+            chunks[i].seg_grp[sg] = groups.cnt - 1 - chunks[i].seg_grp[sg];
+        chunks[i].out_groups = result->groups;
+    }
+
 end:
-    free(buf);
-    fclose(obj_f);
+    for (bgl_obj_group_t *grp = groups.buf; groups.cnt--; ++grp)
+        free(grp->name);
+    free(groups.buf);
 
+    if (err) {
+        if (result)
+            bgl_destroy_obj(result);
+        result = NULL;
+    }
+    errno = err;
+
+    return result;
+}
+
+typedef struct {
+    vec3 normal;
+    int pos;
+    int next;
+} overtex_t;
+
+/*!
+ * @brief Merge corners with the same position and normal into one vertex.
+ * The position index hashes perfectly to the chain of its normal variants,
+ * vertices are emitted in first use order. Triangles with a missing position are dropped.
+ */
+static int deduplicate_corners(bgl_obj_t *obj, const vertex *positions) {
+    obuf_t vtx = BUFFER_INIT;
+    int *head = malloc(obj->v_cnt * sizeof(*head) + 1);
+    int err = 0;
+
+    if (!head)
+        return errno;
+
+    memset(head, 0xFF, obj->v_cnt * sizeof(*head));
+
+    // groups are stored last first
+    for (bgl_obj_group_t *grp = &obj->groups[obj->group_cnt]; grp-- > obj->groups;) {
+        vindex *ind = grp->indices;
+        int n = 0;
+
+        for (int i = 0; i + 2 < grp->i_cnt; i += 3) {
+            if ((unsigned)ind[i].idx >= (unsigned)obj->v_cnt
+                    || (unsigned)ind[i + 1].idx >= (unsigned)obj->v_cnt
+                    || (unsigned)ind[i + 2].idx >= (unsigned)obj->v_cnt)
+                continue;
+
+            for (int k = i; k < i + 3; ++k) {
+                overtex_t *v = vtx.buf;
+                int id = head[ind[k].idx], prev = -1;
+
+                while (id >= 0 && memcmp(v[id].normal, ind[k].normal, sizeof(vec3))) {
+                    prev = id;
+                    id = v[id].next;
+                }
+
+                if (id < 0) {
+                    overtex_t nv = {.pos = ind[k].idx, .next = -1};
+                    glm_vec3_copy(ind[k].normal, nv.normal);
+                    if (!BUF_PUSH_BACK(vtx, overtex_t, nv)) {
+                        err = errno;
+                        goto end;
+                    }
+                    id = vtx.cnt - 1;
+                    if (prev < 0)
+                        head[nv.pos] = id;
+                    else
+                        ((overtex_t *)vtx.buf)[prev].next = id;
+                }
+
+                ind[n] = ind[k];
+                ind[n++].idx = id;
+            }
+        }
+        grp->i_cnt = n;
+    }
+
+    if (!(obj->vertices = malloc(vtx.cnt * sizeof(*obj->vertices) + 1))) {
+        err = errno;
+        goto end;
+    }
+
+    overtex_t *v = vtx.buf;
+    for (int i = 0; i < vtx.cnt; ++i) {
+        obj->vertices[i] = positions[v[i].pos];
+        glm_vec3_copy(v[i].normal, obj->vertices[i].normal);
+    }
+    obj->v_cnt = vtx.cnt;
+
+end:
+    free(head);
+    free(vtx.buf);
+
+    return err;
+}
+
+static bgl_obj_t *load_obj_data(const char *data, size_t size, int threads) {
+    vertex *positions = NULL;
+    vec3 *normals = NULL;
+    bgl_obj_t *result = NULL;
+    int err = 0;
+
+    if (threads <= 0)
+        threads = get_platform_cpu_count();
+    if ((size_t)threads > size / OBJ_MIN_CHUNK + 1)
+        threads = (int)(size / OBJ_MIN_CHUNK + 1);
+
+    obj_chunk_t *chunks = calloc(threads, sizeof(*chunks));
+    if (!chunks) {
+        err = errno;
+        goto end;
+    }
+
+    // split at line boundaries
+    const char *s = data, *end = data + size;
+    int cnt = 0;
+    for (int i = 0; i < threads && s < end; ++i) {
+        const char *e = i == threads - 1 ? end : s + size / threads;
+        if (e < end && !(e = memchr(e, '\n', end - e)))
+            e = end;
+        else if (e < end)
+            ++e;
+
+        chunks[cnt] = (obj_chunk_t){
+                .begin = s, .end = e,
+                .v = BUFFER_INIT, .vn = BUFFER_INIT, .f = BUFFER_INIT, .groups = BUFFER_INIT,
+                .face = BUFFER_INIT, .poly = BUFFER_INIT, .ear = BUFFER_INIT,
+        };
+        ++cnt;
+        s = e;
+    }
+
+    if (!cnt) {
+        chunks[cnt++] = (obj_chunk_t){.begin = end, .end = end, .groups = BUFFER_INIT};
+    }
+
+    run_chunks(parse_chunk, chunks, cnt);
+
+    for (int i = 0; i < cnt; ++i) {
+        if ((err = chunks[i].err))
+            goto end;
+    }
+
+    if (!(result = stitch_chunks(chunks, cnt))) {
+        err = errno;
+        goto end;
+    }
+
+    // every chunk may reference normals from the chunks before it
+    int vn_cnt = chunks[cnt - 1].vn_off + chunks[cnt - 1].vn.cnt;
+    if (!((normals = malloc(vn_cnt * sizeof(*normals) + 1))
+            && (positions = malloc(result->v_cnt * sizeof(*positions) + 1)))) {
+        err = errno;
+        goto end;
+    }
+    for (int i = 0; i < cnt; ++i) {
+        if (chunks[i].vn.cnt)
+            memcpy(&normals[chunks[i].vn_off], chunks[i].vn.buf, chunks[i].vn.cnt * sizeof(*normals));
+        if (chunks[i].v.cnt)
+            memcpy(&positions[chunks[i].v_off], chunks[i].v.buf, chunks[i].v.cnt * sizeof(*positions));
+        chunks[i].normals = normals;
+        chunks[i].positions = positions;
+        chunks[i].v_total = result->v_cnt;
+    }
+
+    run_chunks(fill_chunk, chunks, cnt);
+
+    for (int i = 0; i < cnt; ++i) {
+        if ((err = chunks[i].err))
+            goto end;
+    }
+
+    if (!(err = deduplicate_corners(result, positions)) && !(err = compute_obj_normals(result)))
+        compute_obj_bounds(result);
+
+end:
+    if (chunks) {
+        for (int i = 0; i < threads; ++i)
+            free_chunk(&chunks[i]);
+        free(chunks);
+    }
+    free(normals);
+    free(positions);
+
+    if (err && result) {
+        bgl_destroy_obj(result);
+        result = NULL;
+    }
+    errno = err;
+
+    return result;
+}
+
+typedef struct {
+    const char *data;
+    size_t left;
+} obj_memory_t;
+
+static ptrdiff_t read_memory(void *user, void *buf, size_t size) {
+    obj_memory_t *m = user;
+
+    if (size > m->left)
+        size = m->left;
+    memcpy(buf, m->data, size);
+    m->data += size;
+    m->left -= size;
+
+    return (ptrdiff_t)size;
+}
+
+/*!
+ * @brief Decode the whole input, the parallel parse needs it in memory.
+ */
+static bgl_obj_t *load_obj_reader(bgl_reader r, int threads) {
+    bgl_obj_t *result = NULL;
+    size_t size;
+    char *data;
+
+    if ((data = reader_read_all(r, &size))) {
+        result = load_obj_data(data, size, threads);
+        int err = errno;
+        free(data);
+        errno = err;
+    }
+
+    return result;
+}
+
+BGL_API bgl_obj_t *bgl_load_obj_mt(const char *path, int threads) {
+    obj_memory_t mem;
+    bgl_obj_t *result = NULL;
+    bgl_reader r;
+    size_t size;
+    const char *data;
+    int err;
+
+    if (!(data = map_platform_file(path, &size)))
+        return NULL;
+
+    // plain text is parsed straight from the mapping
+    mem = (obj_memory_t){data, size};
+    if ((r = open_reader(read_memory, &mem))) {
+        result = reader_is_compressed(r) ? load_obj_reader(r, threads) : load_obj_data(data, size, threads);
+        err = errno;
+        close_reader(r);
+    } else {
+        err = errno;
+    }
+
+    unmap_platform_file((void *)data, size);
+    errno = err;
+
+    return result;
+}
+
+BGL_API bgl_obj_t *bgl_load_obj(const char *path) {
+    return bgl_load_obj_mt(path, 1);
+}
+
+BGL_API bgl_obj_t *bgl_load_obj_read(bgl_read_fn read, void *user, int threads) {
     bgl_obj_t *result;
+    bgl_reader r;
+    int err;
 
-    if (!err) {
-        if (!((result = calloc(1, sizeof(*result)))
-                && (result->groups = calloc(groups.cnt, sizeof(*result->groups)))))
-            err = errno;
-        else {
-            result->v_cnt = v.cnt;
-            result->vertices = bgl_realloc_array(v.buf, v.cnt, sizeof(*result->vertices));
-            v.buf = NULL;
-
-            result->group_cnt = groups.cnt;
-            bgl_obj_group_t *grp = result->groups;
-            for (size_t i = result->group_cnt; i--; ++grp) {
-                bgl_obj_group_t *bb = &((bgl_obj_group_t *)groups.buf)[i];
-                grp->name = bb->name;
-                if ((grp->i_cnt = bb->i_cnt))
-                    grp->indices = bb->indices;
+    if (!(r = open_reader(read, user)))
+        return NULL;
+
+    result = load_obj_reader(r, threads);
+    err = errno;
+    close_reader(r);
+    errno = err;
+
+    return result;
+}
+
+BGL_API bgl_obj_t *bgl_load_obj_file(FILE *file, int threads) {
+    return bgl_load_obj_read(read_stdio, file, threads);
+}
+
+#define OBJ_STREAM_BATCH    65536
+#define OBJ_STREAM_READ     (1 << 20)
+
+typedef struct {
+    const bgl_obj_stream_t *cb;
+    int batch;
+
+    vertex *v;
+    vec3 *vn;
+    bgl_obj_corner_t *tri;
+    int v_cnt, vn_cnt, tri_cnt;         // pending in the batch buffers
+    int v_total, vt_total, vn_total;    // seen so far, for relative indices
+    obuf_t face;
+} obj_stream_t;
+
+/*!
+ * @brief Hand the pending batches to the callbacks.
+ * Vertices and normals go first, so triangles never reference data the caller has not seen.
+ */
+static void stream_flush(obj_stream_t *st) {
+    const bgl_obj_stream_t *cb = st->cb;
+
+    if (st->v_cnt && cb->vertices)
+        cb->vertices(st->v, st->v_cnt, cb->user);
+    if (st->vn_cnt && cb->normals)
+        cb->normals((const vec3 *)st->vn, st->vn_cnt, cb->user);
+    if (st->tri_cnt && cb->triangles)
+        cb->triangles(st->tri, st->tri_cnt, cb->user);
+    st->v_cnt = st->vn_cnt = st->tri_cnt = 0;
+}
+
+static int stream_index(int i, int total) {
+    return i < 0 ? total + i : i - 1;
+}
+
+static int stream_line(obj_stream_t *st, const char *s, const char *eol) {
+    vertex vtx;
+    float vval[6];
+
+    s = skip_space(s, eol);
+    if (eol - s < 2)
+        return true;
+
+    switch (*s) {
+    case 'o':   // object name
+        if (!IS_SPACE(s[1]))
+            break;
+        const char *name_end, *name = parse_name(&s[2], eol, &name_end);
+        char *tmp = bgl_strndup(name, name_end - name);
+        if (!tmp)
+            return false;
+        stream_flush(st);
+        if (st->cb->group)
+            st->cb->group(tmp, st->cb->user);
+        free(tmp);
+        break;
+    case 'v':   // vertex data
+        switch (s[1]) {
+        case ' ':   // geometric vertices
+        case '\t':
+            if (parse_vertex(&s[2], eol, &vtx)) {
+                if (st->v_cnt == st->batch)
+                    stream_flush(st);
+                st->v[st->v_cnt++] = vtx;
+                ++st->v_total;
+            }
+            break;
+        case 't':   // texture coordinates, only counted
+            ++st->vt_total;
+            break;
+        case 'n':   // vertex normal
+            if (parse_floats(&s[2], eol, vval) == 3) {
+                if (st->vn_cnt == st->batch)
+                    stream_flush(st);
+                glm_vec3_copy(vval, st->vn[st->vn_cnt++]);
+                ++st->vn_total;
             }
+            break;
         }
+        break;
+    case 'f':   // face
+        if (!IS_SPACE(s[1]))
+            break;
+        int n = parse_face(&s[2], eol, &st->face);
+        oface_t *fval = st->face.buf;
+        if (n < 0)
+            return false;
+
+        // positions are not kept, polygons are fanned
+        for (int i = 1; i < n - 1; ++i) {
+            bgl_obj_corner_t tri[3];
+            int k;
+
+            for (k = 0; k < 3; ++k) {
+                oface_t *c = &fval[k ? i + k - 1 : 0];
+                tri[k] = (bgl_obj_corner_t){
+                        .v = stream_index(c->vi, st->v_total),
+                        .vt = c->vti ? stream_index(c->vti, st->vt_total) : -1,
+                        .vn = c->vni ? stream_index(c->vni, st->vn_total) : -1,
+                };
+                // a corner out of what was passed so far drops the tri
+                if (tri[k].v < 0 || tri[k].v >= st->v_total
+                        || tri[k].vt < -1 || tri[k].vt >= st->vt_total
+                        || tri[k].vn < -1 || tri[k].vn >= st->vn_total)
+                    break;
+            }
+            if (k < 3)
+                continue;
+
+            if (st->tri_cnt + 3 > st->batch)
+                stream_flush(st);
+            memcpy(&st->tri[st->tri_cnt], tri, sizeof(tri));
+            st->tri_cnt += 3;
+        }
+        break;
     }
 
-    if (err) {
-        for (bgl_obj_group_t *grp = groups.buf; groups.cnt--; ++grp) {
-            free(grp->name);
-            free(grp->indices);
+    return true;
+}
+
+static int stream_obj(bgl_reader r, const bgl_obj_stream_t *stream, int batch) {
+    obj_stream_t st = {.cb = stream, .batch = batch > 3 ? batch : OBJ_STREAM_BATCH, .face = BUFFER_INIT};
+    size_t cap = OBJ_STREAM_READ, len = 0;
+    char *buf = NULL;
+    int err = 0;
+
+    st.batch -= st.batch % 3;
+    if (!((buf = malloc(cap))
+            && (st.v = malloc(st.batch * sizeof(*st.v)))
+            && (st.vn = malloc(st.batch * sizeof(*st.vn)))
+            && (st.tri = malloc(st.batch * sizeof(*st.tri))))) {
+        err = errno;
+        goto end;
+    }
+
+    // memory stays bounded by the batch buffers and the longest line,
+    // compressed input is decoded window by window between the parsed lines
+    for (int eof = false; !eof;) {
+        ptrdiff_t n = reader_read(r, &buf[len], cap - len);
+        if (n < 0) {
+            err = errno ? : EIO;
+            goto end;
+        }
+        eof = !n;
+        len += n;
+
+        const char *s = buf, *end = &buf[len], *eol;
+        while (s < end) {
+            if (!(eol = memchr(s, '\n', end - s))) {
+                if (!eof)
+                    break;
+                eol = end;
+            }
+            if (!stream_line(&st, s, eol)) {
+                err = errno;
+                goto end;
+            }
+            s = eol < end ? eol + 1 : end;
+        }
+
+        // keep the partial line, grow only when it fills the whole buffer
+        len = end - s;
+        memmove(buf, s, len);
+        if (len == cap) {
+            char *p = realloc(buf, cap << 1);
+            if (!p) {
+                err = errno;
+                goto end;
+            }
+            buf = p;
+            cap <<= 1;
         }
     }
 
-    free(groups.buf);
-    free(v.buf);
-    free(vn.buf);
-    free(f.buf);
+    stream_flush(&st);
+
+end:
+    free(buf);
+    free(st.v);
+    free(st.vn);
+    free(st.tri);
+    free(st.face.buf);
     errno = err;
 
-    return result;
+    return !err;
+}
+
+BGL_API int bgl_stream_obj(const char *path, const bgl_obj_stream_t *stream, int batch) {
+    FILE *f;
+    int ok, err;
+
+    if (!(f = fopen(path, "rb")))
+        return false;
+
+    ok = bgl_stream_obj_read(read_stdio, f, stream, batch);
+    err = errno;
+    fclose(f);
+    errno = err;
+
+    return ok;
+}
+
+BGL_API int bgl_stream_obj_read(bgl_read_fn read, void *user, const bgl_obj_stream_t *stream, int batch) {
+    bgl_reader r;
+    int ok, err;
+
+    if (!(r = open_reader(read, user)))
+        return false;
+
+    ok = stream_obj(r, stream, batch);
+    err = errno;
+    close_reader(r);
+    errno = err;
+
+    return ok;
 }
 
 BGL_API void bgl_destroy_obj(bgl_obj_t *obj) {
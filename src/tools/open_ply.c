@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <bgl/bglt.h>
+
+#include "internal.h"
+
+
+#define PLY_MAX_ELEMENTS    16
+#define PLY_MAX_PROPS       32
+#define PLY_NAME_LEN        32
+
+typedef enum {
+    PLY_CHAR,
+    PLY_UCHAR,
+    PLY_SHORT,
+    PLY_USHORT,
+    PLY_INT,
+    PLY_UINT,
+    PLY_FLOAT,
+    PLY_DOUBLE,
+} ply_type;
+
+static const struct {
+    const char *name;
+    const char *alias;
+    int size;
+} ply_types[] = {
+        [PLY_CHAR] = {"char", "int8", 1},
+        [PLY_UCHAR] = {"uchar", "uint8", 1},
+        [PLY_SHORT] = {"short", "int16", 2},
+        [PLY_USHORT] = {"ushort", "uint16", 2},
+        [PLY_INT] = {"int", "int32", 4},
+        [PLY_UINT] = {"uint", "uint32", 4},
+        [PLY_FLOAT] = {"float", "float32", 4},
+        [PLY_DOUBLE] = {"double", "float64", 8},
+};
+
+typedef struct {
+    char name[PLY_NAME_LEN];
+    int type;
+    int count_type;     // -1 for a scalar property
+} ply_prop;
+
+typedef struct {
+    char name[PLY_NAME_LEN];
+    uint32_t count;
+    ply_prop props[PLY_MAX_PROPS];
+    int prop_cnt;
+} ply_element;
+
+enum {
+    VP_X, VP_Y, VP_Z,
+    VP_NX, VP_NY, VP_NZ,
+    VP_RED, VP_GREEN, VP_BLUE, VP_ALPHA,
+    VP_CNT,
+};
+
+static const char *const vertex_props[VP_CNT] = {
+        "x", "y", "z", "nx", "ny", "nz", "red", "green", "blue", "alpha",
+};
+
+static int ply_type_by_name(const char *name) {
+    for (int i = 0; i < (int)(sizeof(ply_types) / sizeof(*ply_types)); ++i)
+        if (!strcmp(name, ply_types[i].name) || !strcmp(name, ply_types[i].alias))
+            return i;
+
+    return -1;
+}
+
+static double ply_read(const unsigned char *p, int type, int swap) {
+    switch (type) {
+    case PLY_CHAR:
+        return (int8_t)*p;
+    case PLY_UCHAR:
+        return *p;
+    case PLY_SHORT:
+        return (int16_t)bgl_load_u16(p, swap);
+    case PLY_USHORT:
+        return bgl_load_u16(p, swap);
+    case PLY_INT:
+        return (int32_t)bgl_load_u32(p, swap);
+    case PLY_UINT:
+        return bgl_load_u32(p, swap);
+    case PLY_FLOAT:
+        return bgl_load_f32(p, swap);
+    default:
+        return bgl_load_f64(p, swap);
+    }
+}
+
+static float ply_color(const unsigned char *p, int type, int swap) {
+    double v = ply_read(p, type, swap);
+
+    switch (type) {
+    case PLY_UCHAR:
+        return (float)(v / 255.0);
+    case PLY_USHORT:
+        return (float)(v / 65535.0);
+    default:
+        return (float)v;
+    }
+}
+
+/*!
+ * @brief Locate the properties of one element item, returns its end or NULL when it overruns the data.
+ * `len` receives the list lengths, 1 for scalars.
+ */
+static const unsigned char *ply_item(const ply_element *el, const unsigned char *p, const unsigned char *end,
+                                     int swap, const unsigned char **at, uint32_t *len) {
+    for (int i = 0; i < el->prop_cnt; ++i) {
+        const ply_prop *pr = &el->props[i];
+
+        if (pr->count_type < 0) {
+            at[i] = p;
+            len[i] = 1;
+            if ((size_t)(end - p) < (size_t)ply_types[pr->type].size)
+                return NULL;
+            p += ply_types[pr->type].size;
+            continue;
+        }
+
+        if ((size_t)(end - p) < (size_t)ply_types[pr->count_type].size)
+            return NULL;
+        double n = ply_read(p, pr->count_type, swap);
+        p += ply_types[pr->count_type].size;
+        at[i] = p;
+        if (n < 0 || n > (double)(size_t)(end - p) / ply_types[pr->type].size)
+            return NULL;
+        len[i] = (uint32_t)n;
+        p += (size_t)len[i] * ply_types[pr->type].size;
+    }
+
+    return p;
+}
+
+static const char *parse_header(const char *s, const char *end, int *big_endian,
+                                ply_element *elements, int *el_cnt) {
+    char word[PLY_NAME_LEN], type[PLY_NAME_LEN], count_type[PLY_NAME_LEN], name[PLY_NAME_LEN];
+    ply_element *el = NULL;
+    int format = false;
+    uint32_t count;
+
+    if (end - s < 4 || memcmp(s, "ply", 3) || (s[3] != '\n' && s[3] != '\r'))
+        return NULL;
+
+    *el_cnt = 0;
+    for (const char *eol; s < end; s = eol + 1) {
+        if (!(eol = memchr(s, '\n', end - s)))
+            return NULL;
+
+        char line[256];
+        size_t len = eol - s < (ptrdiff_t)sizeof(line) ? (size_t)(eol - s) : sizeof(line) - 1;
+        memcpy(line, s, len);
+        line[len] = '\0';
+
+        if (sscanf(line, "%31s", word) != 1 || !strcmp(word, "comment") || !strcmp(word, "obj_info"))
+            continue;
+
+        if (!strcmp(word, "end_header"))
+            return format ? eol + 1 : NULL;
+
+        if (!strcmp(word, "format")) {
+            if (sscanf(line, "format %31s", type) != 1)
+                return NULL;
+            if (!strcmp(type, "binary_little_endian"))
+                *big_endian = false;
+            else if (!strcmp(type, "binary_big_endian"))
+                *big_endian = true;
+            else {
+                fprintf(stderr, "Failed to load PLY: %s format is not supported\n", type);
+                return NULL;
+            }
+            format = true;
+        } else if (!strcmp(word, "element")) {
+            if (*el_cnt == PLY_MAX_ELEMENTS || sscanf(line, "element %31s %u", name, &count) != 2)
+                return NULL;
+            el = &elements[(*el_cnt)++];
+            *el = (ply_element){.count = count};
+            strcpy(el->name, name);
+        } else if (!strcmp(word, "property")) {
+            if (!el || el->prop_cnt == PLY_MAX_PROPS)
+                return NULL;
+            ply_prop *pr = &el->props[el->prop_cnt++];
+            if (sscanf(line, "property list %31s %31s %31s", count_type, type, name) == 3) {
+                pr->count_type = ply_type_by_name(count_type);
+                if (pr->count_type < 0 || pr->count_type >= PLY_FLOAT)
+                    return NULL;
+            } else if (sscanf(line, "property %31s %31s", type, name) == 2) {
+                pr->count_type = -1;
+            } else {
+                return NULL;
+            }
+            if ((pr->type = ply_type_by_name(type)) < 0)
+                return NULL;
+            strcpy(pr->name, name);
+        }
+    }
+
+    return NULL;
+}
+
+static int load_vertices(bgl_obj_t *obj, const ply_element *el, const unsigned char **p, const unsigned char *end,
+                         int swap) {
+    const unsigned char *at[PLY_MAX_PROPS];
+    uint32_t len[PLY_MAX_PROPS];
+    int idx[VP_CNT];
+
+    for (int k = 0; k < VP_CNT; ++k) {
+        idx[k] = -1;
+        for (int i = 0; i < el->prop_cnt; ++i)
+            if (el->props[i].count_type < 0 && !strcmp(el->props[i].name, vertex_props[k]))
+                idx[k] = i;
+    }
+    if (idx[VP_X] < 0 || idx[VP_Y] < 0 || idx[VP_Z] < 0)
+        return EINVAL;
+
+    int has_normal = idx[VP_NX] >= 0 && idx[VP_NY] >= 0 && idx[VP_NZ] >= 0;
+    int color_cnt = idx[VP_RED] >= 0 && idx[VP_GREEN] >= 0 && idx[VP_BLUE] >= 0 ? idx[VP_ALPHA] >= 0 ? 4 : 3 : 0;
+
+    // native order float x, y, z side by side are copied as is
+    int direct = !swap && idx[VP_Y] == idx[VP_X] + 1 && idx[VP_Z] == idx[VP_X] + 2
+                 && el->props[idx[VP_X]].type == PLY_FLOAT
+                 && el->props[idx[VP_Y]].type == PLY_FLOAT
+                 && el->props[idx[VP_Z]].type == PLY_FLOAT;
+
+    for (uint32_t n = 0; n < el->count; ++n) {
+        if (!(*p = ply_item(el, *p, end, swap, at, len)))
+            return EINVAL;
+
+        vertex *v = &obj->vertices[n];
+        *v = (vertex){.pos = GLM_VEC4_BLACK_INIT, .color = GLM_VEC4_ONE_INIT};
+
+        if (direct)
+            memcpy(v->pos, at[idx[VP_X]], sizeof(vec3));
+        else
+            for (int k = 0; k < 3; ++k)
+                v->pos[k] = (float)ply_read(at[idx[VP_X + k]], el->props[idx[VP_X + k]].type, swap);
+
+        if (has_normal)
+            for (int k = 0; k < 3; ++k)
+                v->normal[k] = (float)ply_read(at[idx[VP_NX + k]], el->props[idx[VP_NX + k]].type, swap);
+
+        for (int k = 0; k < color_cnt; ++k)
+            v->color[k] = ply_color(at[idx[VP_RED + k]], el->props[idx[VP_RED + k]].type, swap);
+    }
+
+    return 0;
+}
+
+static int load_faces(bgl_obj_t *obj, const ply_element *el, const unsigned char **p, const unsigned char *end,
+                      int swap) {
+    const unsigned char *at[PLY_MAX_PROPS];
+    uint32_t len[PLY_MAX_PROPS];
+    bgl_obj_group_t *grp = obj->groups;
+    int list = -1, cap = 0;
+
+    for (int i = 0; i < el->prop_cnt; ++i)
+        if (el->props[i].count_type >= 0
+                && (!strcmp(el->props[i].name, "vertex_indices") || !strcmp(el->props[i].name, "vertex_index")))
+            list = i;
+
+    for (uint32_t n = 0; n < el->count; ++n) {
+        if (!(*p = ply_item(el, *p, end, swap, at, len)))
+            return EINVAL;
+        if (list < 0)
+            continue;
+
+        int type = el->props[list].type, size = ply_types[type].size;
+
+        // polygons are fanned, triangles with an invalid corner are dropped
+        for (uint32_t i = 1; i + 1 < len[list]; ++i) {
+            uint32_t tri[3] = {0, i, i + 1};
+            int ok = true;
+
+            if (grp->i_cnt + 3 > cap) {
+                if (cap > INT_MAX / 2)
+                    return EFBIG;
+                cap = cap ? cap * 2 : (el->count < INT_MAX / 6 ? (int)el->count * 3 : 0) + 3;
+                vindex *ind = bgl_realloc_array(grp->indices, cap, sizeof(*ind));
+                if (!ind)
+                    return errno;
+                grp->indices = ind;
+            }
+
+            vindex *ind = &grp->indices[grp->i_cnt];
+            for (int k = 0; k < 3 && ok; ++k) {
+                double id = ply_read(&at[list][tri[k] * size], type, swap);
+                ind[k] = (vindex){.idx = (int)id, .color = GLM_VEC4_ONE_INIT};
+                ok = id >= 0 && id < obj->v_cnt;
+            }
+            if (ok)
+                grp->i_cnt += 3;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+ * @brief Load a binary PLY in either byte order, vertex colors and normals are kept when present.
+ */
+BGL_API bgl_obj_t *bgl_load_ply(const char *path) {
+    ply_element elements[PLY_MAX_ELEMENTS];
+    int el_cnt, big_endian = false;
+    const char *data;
+    size_t size;
+    bgl_obj_t *obj = NULL;
+    int err = 0;
+
+    if (!(data = map_platform_file(path, &size)))
+        return NULL;
+
+    const unsigned char *p = (const unsigned char *)parse_header(data, data + size, &big_endian, elements, &el_cnt);
+    const unsigned char *end = (const unsigned char *)data + size;
+    int swap = big_endian != BGL_BIG_ENDIAN;
+    const ply_element *vert = NULL;
+
+    for (int i = 0; i < el_cnt && p; ++i)
+        if (!strcmp(elements[i].name, "vertex"))
+            vert = &elements[i];
+    if (!p || !vert || vert->count > INT_MAX / 3) {
+        fprintf(stderr, "Failed to load PLY: %s: invalid header\n", path);
+        err = EINVAL;
+        goto end;
+    }
+
+    if (!((obj = calloc(1, sizeof(*obj)))
+            && (obj->groups = calloc(1, sizeof(*obj->groups)))
+            && (obj->vertices = malloc(vert->count * sizeof(vertex) + 1)))) {
+        err = errno;
+        goto end;
+    }
+    obj->group_cnt = 1;
+
+    // faces may come first, their indices are checked against the declared vertex count
+    obj->v_cnt = (int)vert->count;
+    for (int i = 0; i < el_cnt && !err; ++i) {
+        const ply_element *el = &elements[i];
+        const unsigned char *at[PLY_MAX_PROPS];
+        uint32_t len[PLY_MAX_PROPS];
+
+        if (el == vert)
+            err = load_vertices(obj, el, &p, end, swap);
+        else if (!strcmp(el->name, "face"))
+            err = load_faces(obj, el, &p, end, swap);
+        else
+            for (uint32_t n = 0; n < el->count && !err; ++n)
+                err = (p = ply_item(el, p, end, swap, at, len)) ? 0 : EINVAL;
+    }
+    if (err) {
+        fprintf(stderr, "Failed to load PLY: %s: %s\n", path, err == EINVAL ? "truncated file" : strerror(err));
+        goto end;
+    }
+
+    bgl_obj_group_t *grp = obj->groups;
+    for (int i = 0; i < grp->i_cnt; ++i)
+        glm_vec3_copy(obj->vertices[grp->indices[i].idx].normal, grp->indices[i].normal);
+
+    if (!obj->groups->indices && !(obj->groups->indices = malloc(1))) {
+        err = errno;
+        goto end;
+    }
+
+    if (!(err = compute_obj_normals(obj)))
+        compute_obj_bounds(obj);
+
+end:
+    unmap_platform_file((void *)data, size);
+
+    if (err && obj) {
+        obj->group_cnt = obj->groups ? 1 : 0;
+        bgl_destroy_obj(obj);
+        obj = NULL;
+    }
+    errno = err;
+
+    return obj;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <bgl/bglt.h>
+
+#include "internal.h"
+
+
+#define STL_HEADER  84
+#define STL_RECORD  50
+
+static uint32_t corner_hash(const float pos[3], const float normal[3]) {
+    uint32_t h = 2166136261u, w;
+
+    for (int k = 0; k < 6; ++k) {
+        memcpy(&w, k < 3 ? &pos[k] : &normal[k - 3], sizeof(w));
+        h = (h ^ w) * 16777619u;
+    }
+
+    return h ^ h >> 15;
+}
+
+/*!
+ * @brief Load a binary STL, corners sharing position and facet normal are merged.
+ */
+BGL_API bgl_obj_t *bgl_load_stl(const char *path) {
+    const unsigned char *data;
+    size_t size;
+    bgl_obj_t *obj = NULL;
+    int *table = NULL;
+    int err = 0;
+
+    if (!(data = map_platform_file(path, &size)))
+        return NULL;
+
+    uint32_t tri_cnt = size >= STL_HEADER ? bgl_load_u32(&data[80], BGL_BIG_ENDIAN) : 0;
+    if (size < STL_HEADER || (size - STL_HEADER) / STL_RECORD < tri_cnt) {
+        if (size >= 5 && !memcmp(data, "solid", 5))
+            fprintf(stderr, "Failed to load STL: %s: ASCII STL is not supported\n", path);
+        else
+            fprintf(stderr, "Failed to load STL: %s: truncated file\n", path);
+        err = EINVAL;
+        goto end;
+    }
+    if (tri_cnt > INT_MAX / 6) {
+        fprintf(stderr, "Failed to load STL: %s: too many triangles: %u\n", path, tri_cnt);
+        err = EFBIG;
+        goto end;
+    }
+
+    // open addressing, at most half full
+    int i_cnt = (int)tri_cnt * 3;
+    uint32_t mask = 15;
+    while (mask < (uint32_t)i_cnt * 2)
+        mask = mask << 1 | 1;
+
+    if (!((obj = calloc(1, sizeof(*obj)))
+            && (obj->groups = calloc(1, sizeof(*obj->groups)))
+            && (obj->groups->indices = malloc(i_cnt * sizeof(vindex) + 1))
+            && (obj->vertices = malloc(i_cnt * sizeof(vertex) + 1))
+            && (table = malloc(((size_t)mask + 1) * sizeof(*table))))) {
+        err = errno;
+        goto end;
+    }
+    obj->group_cnt = 1;
+    memset(table, 0xFF, ((size_t)mask + 1) * sizeof(*table));
+
+    // records are little endian floats, read straight from the mapping
+    const unsigned char *rec = &data[STL_HEADER];
+    vindex *ind = obj->groups->indices;
+    for (uint32_t t = 0; t < tri_cnt; ++t, rec += STL_RECORD) {
+        vec3 normal;
+        for (int k = 0; k < 3; ++k)
+            normal[k] = bgl_load_f32(&rec[k * 4], BGL_BIG_ENDIAN);
+
+        for (int c = 0; c < 3; ++c) {
+            vec3 pos;
+            for (int k = 0; k < 3; ++k)
+                pos[k] = bgl_load_f32(&rec[12 + c * 12 + k * 4], BGL_BIG_ENDIAN);
+
+            uint32_t slot = corner_hash(pos, normal) & mask;
+            int id;
+            while ((id = table[slot]) >= 0
+                    && (memcmp(obj->vertices[id].pos, pos, sizeof(vec3))
+                        || memcmp(obj->vertices[id].normal, normal, sizeof(vec3))))
+                slot = (slot + 1) & mask;
+
+            if (id < 0) {
+                id = table[slot] = obj->v_cnt++;
+                vertex *v = &obj->vertices[id];
+                *v = (vertex){.pos = GLM_VEC4_BLACK_INIT, .color = GLM_VEC4_ONE_INIT};
+                glm_vec3_copy(pos, v->pos);
+                glm_vec3_copy(normal, v->normal);
+            }
+
+            *ind = (vindex){.idx = id, .color = GLM_VEC4_ONE_INIT};
+            glm_vec3_copy(normal, ind->normal);
+            ++ind;
+        }
+    }
+    obj->groups->i_cnt = i_cnt;
+
+    vertex *shrunk = realloc(obj->vertices, obj->v_cnt * sizeof(vertex) + 1);
+    if (shrunk)
+        obj->vertices = shrunk;
+
+    // exporters often leave the facet normal zeroed
+    if (!(err = compute_obj_normals(obj)))
+        compute_obj_bounds(obj);
+
+end:
+    unmap_platform_file((void *)data, size);
+    free(table);
+
+    if (err && obj) {
+        obj->group_cnt = obj->groups ? 1 : 0;
+        bgl_destroy_obj(obj);
+        obj = NULL;
+    }
+    errno = err;
+
+    return obj;
+}
@@ -0,0 +1,627 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <errno.h>
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <bgl/bglt.h>
+
+#include "internal.h"
+
+
+#define FIFO_CACHE_SIZE 16  // cache model for statistics and overdraw clustering
+#define LRU_CACHE_SIZE 32   // cache model for the Forsyth scoring
+#define OVERDRAW_GRID 256   // overdraw raster resolution per view
+
+typedef struct {
+    size_t tris;
+    size_t misses;
+    size_t unique;
+    size_t shaded;
+    size_t covered;
+} mesh_counters;
+
+typedef struct {
+    int start;
+    int end;
+    float key;
+} tri_cluster;
+
+static int check_indices(const vindex *indices, int i_cnt, int v_cnt) {
+    for (int i = 0; i < i_cnt; ++i) {
+        if (indices[i].idx < 0 || indices[i].idx >= v_cnt) {
+            errno = EINVAL;
+            return false;
+        }
+    }
+    return true;
+}
+
+/// statistics
+
+static void count_cache_misses(const vindex *indices, int i_cnt, int *stamps, int *time, mesh_counters *cnt) {
+    for (int i = 0; i < i_cnt - 2; i += 3) {
+        for (int k = 0; k < 3; ++k) {
+            int v = indices[i + k].idx;
+            if (*time - stamps[v] > FIFO_CACHE_SIZE) {
+                stamps[v] = (*time)++;
+                ++cnt->misses;
+            }
+        }
+        ++cnt->tris;
+    }
+}
+
+static size_t fifo_misses(const vindex *indices, int i_cnt, int *stamps, int v_cnt) {
+    mesh_counters cnt = {0};
+    int time = FIFO_CACHE_SIZE + 1;
+
+    memset(stamps, 0, v_cnt * sizeof(*stamps));
+    count_cache_misses(indices, i_cnt, stamps, &time, &cnt);
+
+    return cnt.misses;
+}
+
+static void rasterize_overdraw(float *depth, const vec3 a, const vec3 b, const vec3 c, float area, mesh_counters *cnt) {
+    float min_u = glm_min(a[0], glm_min(b[0], c[0]));
+    float max_u = glm_max(a[0], glm_max(b[0], c[0]));
+    float min_v = glm_min(a[1], glm_min(b[1], c[1]));
+    float max_v = glm_max(a[1], glm_max(b[1], c[1]));
+    float sign = area < 0 ? -1.0f : 1.0f;
+
+    int x0 = (int)glm_max(ceilf(min_u - 0.5f), 0);
+    int x1 = (int)glm_min(floorf(max_u - 0.5f), OVERDRAW_GRID - 1);
+    int y0 = (int)glm_max(ceilf(min_v - 0.5f), 0);
+    int y1 = (int)glm_min(floorf(max_v - 0.5f), OVERDRAW_GRID - 1);
+
+    area *= sign;
+
+    for (int y = y0; y <= y1; ++y) {
+        float py = (float)y + 0.5f;
+        for (int x = x0; x <= x1; ++x) {
+            float px = (float)x + 0.5f;
+            float w0 = sign * ((c[0] - b[0]) * (py - b[1]) - (c[1] - b[1]) * (px - b[0]));
+            float w1 = sign * ((a[0] - c[0]) * (py - c[1]) - (a[1] - c[1]) * (px - c[0]));
+            float w2 = sign * ((b[0] - a[0]) * (py - a[1]) - (b[1] - a[1]) * (px - a[0]));
+
+            if (w0 < 0 || w1 < 0 || w2 < 0)
+                continue;
+
+            float z = (w0 * a[2] + w1 * b[2] + w2 * c[2]) / area;
+            float *d = &depth[y * OVERDRAW_GRID + x];
+            if (z < *d) {
+                if (*d == FLT_MAX)
+                    ++cnt->covered;
+                *d = z;
+                ++cnt->shaded;
+            }
+        }
+    }
+}
+
+/*!
+ * @brief Count shaded and covered pixels from six axis-aligned orthographic views.
+ * Back faces are skipped the same way the pipeline culls them.
+ */
+static int count_overdraw(const vertex *vertices, int v_cnt, vindex **lists, const int *counts, int list_cnt,
+                          mesh_counters *cnt) {
+    vec3 min = {FLT_MAX, FLT_MAX, FLT_MAX}, max = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    float *depth;
+
+    for (int i = 0; i < v_cnt; ++i) {
+        glm_vec3_minv(min, (float *)vertices[i].pos, min);
+        glm_vec3_maxv(max, (float *)vertices[i].pos, max);
+    }
+
+    float extent = glm_max(max[0] - min[0], glm_max(max[1] - min[1], max[2] - min[2]));
+    float scale = extent > 0 ? (float)(OVERDRAW_GRID - 1) / extent : 0;
+
+    if (!(depth = malloc(OVERDRAW_GRID * OVERDRAW_GRID * sizeof(*depth))))
+        return false;
+
+    for (int view = 0; view < 6; ++view) {
+        int axis = view >> 1, u = (axis + 1) % 3, v = (axis + 2) % 3;
+        float sign = (view & 1) ? -1.0f : 1.0f;
+
+        for (int i = 0; i < OVERDRAW_GRID * OVERDRAW_GRID; ++i)
+            depth[i] = FLT_MAX;
+
+        for (int l = 0; l < list_cnt; ++l) {
+            for (int i = 0; i < counts[l] - 2; i += 3) {
+                vec3 p[3];
+                for (int k = 0; k < 3; ++k) {
+                    const float *pos = vertices[lists[l][i + k].idx].pos;
+                    p[k][0] = (pos[u] - min[u]) * scale;
+                    p[k][1] = (pos[v] - min[v]) * scale;
+                    p[k][2] = sign * (pos[axis] - min[axis]) * scale;
+                }
+
+                float area = (p[1][0] - p[0][0]) * (p[2][1] - p[0][1]) - (p[2][0] - p[0][0]) * (p[1][1] - p[0][1]);
+                if (sign * area < 0)
+                    rasterize_overdraw(depth, p[0], p[1], p[2], area, cnt);
+            }
+        }
+    }
+
+    free(depth);
+
+    return true;
+}
+
+static int analyze_lists(const vertex *vertices, int v_cnt, vindex **lists, const int *counts, int list_cnt,
+                         bgl_mesh_stats_t *stats) {
+    mesh_counters cnt = {0};
+    int *stamps, time;
+
+    if (!(stamps = malloc(v_cnt * sizeof(*stamps))))
+        return false;
+
+    for (int i = 0; i < v_cnt; ++i)
+        stamps[i] = -1;
+    for (int l = 0; l < list_cnt; ++l)
+        for (int i = 0; i < counts[l]; ++i)
+            if (stamps[lists[l][i].idx] < 0)
+                stamps[lists[l][i].idx] = 0, ++cnt.unique;
+
+    for (int l = 0; l < list_cnt; ++l) {
+        // every draw starts with a cold cache
+        time = FIFO_CACHE_SIZE + 1;
+        for (int i = 0; i < v_cnt; ++i)
+            stamps[i] = 0;
+        count_cache_misses(lists[l], counts[l], stamps, &time, &cnt);
+    }
+
+    free(stamps);
+
+    if (!count_overdraw(vertices, v_cnt, lists, counts, list_cnt, &cnt))
+        return false;
+
+    stats->acmr = cnt.tris ? (float)cnt.misses / (float)cnt.tris : 0;
+    stats->atvr = cnt.unique ? (float)cnt.misses / (float)cnt.unique : 0;
+    stats->overdraw = cnt.covered ? (float)cnt.shaded / (float)cnt.covered : 0;
+
+    return true;
+}
+
+/// vertex cache (Forsyth)
+
+static float vertex_score(const float *cache_tab, int cache_pos, int remaining) {
+    if (!remaining)
+        return -1.0f;
+
+    float score = cache_pos >= 0 ? cache_tab[cache_pos] : 0;
+
+    return score + 2.0f / sqrtf((float)remaining);
+}
+
+static int optimize_vertex_cache(vindex *indices, int i_cnt, int v_cnt) {
+    int t_cnt = i_cnt / 3;
+    int *offsets = calloc(v_cnt + 1, sizeof(*offsets));
+    int *live = calloc(v_cnt, sizeof(*live));
+    int *cache_pos = malloc(v_cnt * sizeof(*cache_pos));
+    float *v_score = malloc(v_cnt * sizeof(*v_score));
+    int *adjacency = malloc(t_cnt * 3 * sizeof(*adjacency));
+    float *t_score = malloc(t_cnt * sizeof(*t_score));
+    char *emitted = calloc(t_cnt, sizeof(*emitted));
+    vindex *out = malloc(t_cnt * 3 * sizeof(*out));
+    int cache[LRU_CACHE_SIZE + 3], new_cache[LRU_CACHE_SIZE + 3];
+    int cache_cnt = 0, cursor = 0, best = -1;
+    float cache_tab[LRU_CACHE_SIZE];
+    int ret = false;
+
+    if (!(offsets && live && cache_pos && v_score && adjacency && t_score && emitted && out))
+        goto end;
+
+    for (int i = 0; i < LRU_CACHE_SIZE; ++i)
+        cache_tab[i] = i < 3 ? 0.75f : powf(1.0f - (float)(i - 3) / (LRU_CACHE_SIZE - 3), 1.5f);
+
+    for (int i = 0; i < t_cnt * 3; ++i)
+        ++live[indices[i].idx];
+    for (int v = 0; v < v_cnt; ++v)
+        offsets[v + 1] = offsets[v] + live[v];
+    memset(live, 0, v_cnt * sizeof(*live));
+    for (int i = 0; i < t_cnt * 3; ++i) {
+        int v = indices[i].idx;
+        adjacency[offsets[v] + live[v]++] = i / 3;
+    }
+
+    for (int v = 0; v < v_cnt; ++v) {
+        cache_pos[v] = -1;
+        v_score[v] = vertex_score(cache_tab, -1, live[v]);
+    }
+    for (int t = 0; t < t_cnt; ++t)
+        t_score[t] = v_score[indices[t * 3].idx] + v_score[indices[t * 3 + 1].idx] + v_score[indices[t * 3 + 2].idx];
+
+    for (int emitted_cnt = 0; emitted_cnt < t_cnt; ++emitted_cnt) {
+        if (best < 0) {
+            while (emitted[cursor])
+                ++cursor;
+            best = cursor;
+        }
+
+        memcpy(&out[emitted_cnt * 3], &indices[best * 3], 3 * sizeof(*out));
+        emitted[best] = 1;
+
+        // the emitted triangle goes to the front of the cache
+        int new_cnt = 0;
+        for (int k = 0; k < 3; ++k) {
+            int v = indices[best * 3 + k].idx;
+            int dup = 0;
+            for (int j = 0; j < new_cnt; ++j)
+                dup |= new_cache[j] == v;
+            if (!dup)
+                new_cache[new_cnt++] = v;
+
+            // drop the triangle from the vertex adjacency
+            int *adj = &adjacency[offsets[v]];
+            for (int j = 0; j < live[v]; ++j) {
+                if (adj[j] == best) {
+                    adj[j] = adj[--live[v]];
+                    break;
+                }
+            }
+        }
+        for (int j = 0; j < cache_cnt; ++j) {
+            int v = cache[j];
+            if (v != new_cache[0] && (new_cnt < 2 || v != new_cache[1]) && (new_cnt < 3 || v != new_cache[2]))
+                new_cache[new_cnt++] = v;
+        }
+
+        // rescore vertices that moved in (or fell out of) the cache
+        for (int j = 0; j < new_cnt; ++j) {
+            int v = new_cache[j];
+            cache_pos[v] = j < LRU_CACHE_SIZE ? j : -1;
+
+            float score = vertex_score(cache_tab, cache_pos[v], live[v]);
+            float diff = score - v_score[v];
+            v_score[v] = score;
+
+            for (int *adj = &adjacency[offsets[v]], n = live[v]; n--; ++adj)
+                t_score[*adj] += diff;
+        }
+
+        cache_cnt = new_cnt < LRU_CACHE_SIZE ? new_cnt : LRU_CACHE_SIZE;
+        memcpy(cache, new_cache, cache_cnt * sizeof(*cache));
+
+        best = -1;
+        float best_score = -FLT_MAX;
+        for (int j = 0; j < cache_cnt; ++j) {
+            int v = cache[j];
+            for (int *adj = &adjacency[offsets[v]], n = live[v]; n--; ++adj) {
+                if (t_score[*adj] > best_score) {
+                    best_score = t_score[*adj];
+                    best = *adj;
+                }
+            }
+        }
+    }
+
+    // keep the input order if it already suits the cache better (e.g. strip-ordered meshes)
+    if (fifo_misses(out, t_cnt * 3, cache_pos, v_cnt) < fifo_misses(indices, t_cnt * 3, cache_pos, v_cnt))
+        memcpy(indices, out, t_cnt * 3 * sizeof(*out));
+    ret = true;
+
+end:
+    free(offsets);
+    free(live);
+    free(cache_pos);
+    free(v_score);
+    free(adjacency);
+    free(t_score);
+    free(emitted);
+    free(out);
+
+    return ret;
+}
+
+/// overdraw (Tipsify-style clusters sorted front to back)
+
+static int cmp_cluster(const tri_cluster *a, const tri_cluster *b) {
+    if (a->key > b->key)
+        return -1;
+    if (a->key < b->key)
+        return 1;
+    return a->start - b->start;
+}
+
+static int tri_misses(const vindex *tri, int *stamps, int *time) {
+    int misses = 0;
+
+    for (int k = 0; k < 3; ++k) {
+        if (*time - stamps[tri[k].idx] > FIFO_CACHE_SIZE) {
+            stamps[tri[k].idx] = (*time)++;
+            ++misses;
+        }
+    }
+
+    return misses;
+}
+
+static int optimize_overdraw(const vertex *vertices, int v_cnt, vindex *indices, int i_cnt, float threshold) {
+    int t_cnt = i_cnt / 3;
+    int *stamps = calloc(v_cnt, sizeof(*stamps));
+    int *hard = malloc((t_cnt + 1) * sizeof(*hard));
+    tri_cluster *clusters = malloc(t_cnt * sizeof(*clusters));
+    vindex *out = malloc(t_cnt * 3 * sizeof(*out));
+    int hard_cnt = 0, cluster_cnt = 0, time = FIFO_CACHE_SIZE + 1;
+    vec3 mesh_center = GLM_VEC3_ZERO_INIT;
+    int ret = false;
+
+    if (!(stamps && hard && clusters && out))
+        goto end;
+
+    // hard boundaries: triangles that miss the cache on every vertex
+    for (int t = 0; t < t_cnt; ++t)
+        if (tri_misses(&indices[t * 3], stamps, &time) == 3)
+            hard[hard_cnt++] = t;
+    hard[hard_cnt] = t_cnt;
+
+    // soft boundaries: split while the local ACMR stays within threshold
+    for (int h = 0; h < hard_cnt; ++h) {
+        int start = hard[h], end = hard[h + 1], misses = 0;
+
+        time += FIFO_CACHE_SIZE + 1;
+        for (int t = start; t < end; ++t)
+            misses += tri_misses(&indices[t * 3], stamps, &time);
+
+        float limit = threshold * (float)misses / (float)(end - start);
+
+        clusters[cluster_cnt++].start = start;
+        time += FIFO_CACHE_SIZE + 1;
+        misses = 0;
+        for (int t = start, size = 0; t < end; ++t) {
+            misses += tri_misses(&indices[t * 3], stamps, &time);
+            ++size;
+            if (t + 1 < end && size > 1 && (float)misses / (float)size <= limit) {
+                clusters[cluster_cnt++].start = t + 1;
+                time += FIFO_CACHE_SIZE + 1;
+                misses = size = 0;
+            }
+        }
+    }
+
+    for (int v = 0; v < v_cnt; ++v)
+        glm_vec3_add(mesh_center, (float *)vertices[v].pos, mesh_center);
+    if (v_cnt)
+        glm_vec3_divs(mesh_center, (float)v_cnt, mesh_center);
+
+    for (int c = 0; c < cluster_cnt; ++c) {
+        vec3 center = GLM_VEC3_ZERO_INIT, normal = GLM_VEC3_ZERO_INIT, u, v, n;
+        float area = 0;
+
+        clusters[c].end = c + 1 < cluster_cnt ? clusters[c + 1].start : t_cnt;
+
+        for (int t = clusters[c].start; t < clusters[c].end; ++t) {
+            const float *a = vertices[indices[t * 3].idx].pos;
+            const float *b = vertices[indices[t * 3 + 1].idx].pos;
+            const float *d = vertices[indices[t * 3 + 2].idx].pos;
+
+            glm_vec3_sub((float *)b, (float *)a, u);
+            glm_vec3_sub((float *)d, (float *)a, v);
+            glm_vec3_cross(u, v, n);
+
+            float w = glm_vec3_norm(n);
+            for (int k = 0; k < 3; ++k)
+                center[k] += (a[k] + b[k] + d[k]) * (w / 3.0f);
+            glm_vec3_add(normal, n, normal);
+            area += w;
+        }
+
+        if (area > 0)
+            glm_vec3_divs(center, area, center);
+        glm_vec3_normalize(normal);
+        glm_vec3_sub(center, mesh_center, center);
+
+        // clusters on the outside of the mesh facing outwards occlude the rest
+        clusters[c].key = glm_vec3_dot(center, normal);
+    }
+
+    qsort(clusters, cluster_cnt, sizeof(*clusters), (int (*)(const void *, const void *))cmp_cluster);
+
+    vindex *dst = out;
+    for (int c = 0; c < cluster_cnt; ++c) {
+        int n = (clusters[c].end - clusters[c].start) * 3;
+        memcpy(dst, &indices[clusters[c].start * 3], n * sizeof(*dst));
+        dst += n;
+    }
+
+    memcpy(indices, out, t_cnt * 3 * sizeof(*out));
+    ret = true;
+
+end:
+    free(stamps);
+    free(hard);
+    free(clusters);
+    free(out);
+
+    return ret;
+}
+
+/// vertex deduplication and fetch order
+
+static uint32_t hash_vertex(const vertex *v) {
+    const uint8_t *p = (const uint8_t *)v;
+    uint32_t h = 2166136261u;
+
+    // padding after the normal is not part of the key
+    for (size_t i = 0; i < offsetof(vertex, normal) + sizeof(vec3); ++i)
+        h = (h ^ p[i]) * 16777619u;
+
+    return h;
+}
+
+static int remap_vertices(vertex *vertices, int v_cnt, vindex **lists, const int *counts, int list_cnt,
+                          const int *remap, int new_cnt) {
+    vertex *tmp = bgl_aligned_alloc(16, (new_cnt ? new_cnt : 1) * sizeof(*tmp));
+
+    if (!tmp)
+        return -1;
+
+    for (int v = 0; v < v_cnt; ++v)
+        if (remap[v] >= 0)
+            tmp[remap[v]] = vertices[v];
+    memcpy(vertices, tmp, new_cnt * sizeof(*tmp));
+    bgl_aligned_free(tmp);
+
+    for (int l = 0; l < list_cnt; ++l)
+        for (int i = 0; i < counts[l]; ++i)
+            lists[l][i].idx = remap[lists[l][i].idx];
+
+    return new_cnt;
+}
+
+static int deduplicate_vertices(vertex *vertices, int v_cnt, vindex **lists, const int *counts, int list_cnt) {
+    size_t key_sz = offsetof(vertex, normal) + sizeof(vec3);
+    size_t table_sz = 1;
+    int *table, *remap, *first;
+    int new_cnt = 0;
+
+    while (table_sz < (size_t)v_cnt * 2)
+        table_sz <<= 1;
+
+    table = malloc(table_sz * sizeof(*table));
+    remap = malloc(v_cnt * sizeof(*remap));
+    first = malloc(v_cnt * sizeof(*first));
+    if (!(table && remap && first)) {
+        new_cnt = -1;
+        goto end;
+    }
+
+    memset(table, 0xFF, table_sz * sizeof(*table));
+
+    for (int v = 0; v < v_cnt; ++v) {
+        size_t slot = hash_vertex(&vertices[v]) & (table_sz - 1);
+
+        while (table[slot] >= 0 && memcmp(&vertices[first[table[slot]]], &vertices[v], key_sz))
+            slot = (slot + 1) & (table_sz - 1);
+
+        if (table[slot] < 0) {
+            first[new_cnt] = v;
+            table[slot] = new_cnt++;
+        }
+        remap[v] = table[slot];
+    }
+
+    new_cnt = remap_vertices(vertices, v_cnt, lists, counts, list_cnt, remap, new_cnt);
+
+end:
+    free(table);
+    free(remap);
+    free(first);
+
+    return new_cnt;
+}
+
+static int optimize_vertex_fetch(vertex *vertices, int v_cnt, vindex **lists, const int *counts, int list_cnt) {
+    int *remap = malloc(v_cnt * sizeof(*remap));
+    int new_cnt = 0;
+
+    if (!remap)
+        return -1;
+
+    memset(remap, 0xFF, v_cnt * sizeof(*remap));
+
+    // first-use order; unreferenced vertices are dropped
+    for (int l = 0; l < list_cnt; ++l)
+        for (int i = 0; i < counts[l]; ++i)
+            if (remap[lists[l][i].idx] < 0)
+                remap[lists[l][i].idx] = new_cnt++;
+
+    new_cnt = remap_vertices(vertices, v_cnt, lists, counts, list_cnt, remap, new_cnt);
+    free(remap);
+
+    return new_cnt;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BGL_API int bgl_analyze_mesh(const vertex *vertices, int v_cnt, const vindex *indices, int i_cnt,
+                             bgl_mesh_stats_t *stats) {
+    vindex *list = (vindex *)indices;
+
+    if (!check_indices(indices, i_cnt, v_cnt))
+        return false;
+
+    return analyze_lists(vertices, v_cnt, &list, &i_cnt, 1, stats);
+}
+
+BGL_API int bgl_optimize_vertex_cache(vindex *indices, int i_cnt, int v_cnt) {
+    if (!check_indices(indices, i_cnt, v_cnt))
+        return false;
+
+    return optimize_vertex_cache(indices, i_cnt, v_cnt);
+}
+
+BGL_API int bgl_optimize_overdraw(const vertex *vertices, int v_cnt, vindex *indices, int i_cnt, float threshold) {
+    if (!check_indices(indices, i_cnt, v_cnt))
+        return false;
+
+    return optimize_overdraw(vertices, v_cnt, indices, i_cnt, threshold);
+}
+
+BGL_API int bgl_deduplicate_vertices(vertex *vertices, int v_cnt, vindex *indices, int i_cnt) {
+    if (!check_indices(indices, i_cnt, v_cnt))
+        return -1;
+
+    return deduplicate_vertices(vertices, v_cnt, &indices, &i_cnt, 1);
+}
+
+BGL_API int bgl_optimize_vertex_fetch(vertex *vertices, int v_cnt, vindex *indices, int i_cnt) {
+    if (!check_indices(indices, i_cnt, v_cnt))
+        return -1;
+
+    return optimize_vertex_fetch(vertices, v_cnt, &indices, &i_cnt, 1);
+}
+
+BGL_API int bgl_optimize_obj(bgl_obj_t *obj, bgl_mesh_stats_t *before, bgl_mesh_stats_t *after) {
+    vindex **lists = calloc(obj->group_cnt + 1, sizeof(*lists));
+    int *counts = calloc(obj->group_cnt + 1, sizeof(*counts));
+    int v_cnt, ret = false;
+
+    if (!(lists && counts))
+        goto end;
+
+    for (int g = 0; g < obj->group_cnt; ++g) {
+        lists[g] = obj->groups[g].indices;
+        counts[g] = obj->groups[g].i_cnt;
+        if (!check_indices(lists[g], counts[g], obj->v_cnt))
+            goto end;
+    }
+
+    if (before && !analyze_lists(obj->vertices, obj->v_cnt, lists, counts, obj->group_cnt, before))
+        goto end;
+
+    for (int g = 0; g < obj->group_cnt; ++g) {
+        if (!(optimize_vertex_cache(lists[g], counts[g], obj->v_cnt)
+                && optimize_overdraw(obj->vertices, obj->v_cnt, lists[g], counts[g], 1.05f)))
+            goto end;
+    }
+
+    if ((v_cnt = deduplicate_vertices(obj->vertices, obj->v_cnt, lists, counts, obj->group_cnt)) < 0)
+        goto end;
+    obj->v_cnt = v_cnt;
+
+    if ((v_cnt = optimize_vertex_fetch(obj->vertices, obj->v_cnt, lists, counts, obj->group_cnt)) < 0)
+        goto end;
+    obj->v_cnt = v_cnt;
+
+    if (after && !analyze_lists(obj->vertices, obj->v_cnt, lists, counts, obj->group_cnt, after))
+        goto end;
+
+    ret = true;
+
+end:
+    free(lists);
+    free(counts);
+
+    return ret;
+}
@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(BGL_HAVE_ZLIB)
+# include <zlib.h>
+#endif
+#if defined(BGL_HAVE_ZSTD)
+# include <zstd.h>
+#endif
+
+#include <bgl/bglt.h>
+
+#include "internal.h"
+
+
+#define READER_IN_SIZE (1 << 16)
+
+enum {
+    CODEC_NONE,
+    CODEC_GZIP,
+    CODEC_ZSTD,
+};
+
+struct bgl_reader {
+    bgl_read_fn read;
+    void *user;
+    int codec;
+    int eof;
+
+    // compressed input
+    unsigned char *in;
+    size_t in_len;
+    size_t in_pos;
+
+#if defined(BGL_HAVE_ZLIB)
+    z_stream z;
+#endif
+#if defined(BGL_HAVE_ZSTD)
+    ZSTD_DStream *zs;
+    size_t zs_hint;     // non zero while a frame is incomplete
+#endif
+};
+
+static ptrdiff_t fill_input(bgl_reader r) {
+    ptrdiff_t n;
+
+    if (r->in_pos < r->in_len || r->eof)
+        return (ptrdiff_t)(r->in_len - r->in_pos);
+
+    if ((n = r->read(r->user, r->in, READER_IN_SIZE)) < 0)
+        return -1;
+
+    r->in_len = (size_t)n;
+    r->in_pos = 0;
+    r->eof = !n;
+
+    return n;
+}
+
+#if defined(BGL_HAVE_ZLIB)
+static ptrdiff_t read_gzip(bgl_reader r, void *buf, size_t size) {
+    if (size > UINT_MAX)
+        size = UINT_MAX;
+    r->z.next_out = buf;
+    r->z.avail_out = (uInt)size;
+
+    while (r->z.avail_out == size) {
+        if (fill_input(r) < 0)
+            return -1;
+
+        // decoder may still hold output after the input is gone
+        r->z.next_in = &r->in[r->in_pos];
+        r->z.avail_in = (uInt)(r->in_len - r->in_pos);
+
+        int ret = inflate(&r->z, Z_NO_FLUSH);
+        r->in_pos = r->in_len - r->z.avail_in;
+
+        // concatenated members continue the stream
+        if (ret == Z_STREAM_END)
+            ret = inflateReset(&r->z);
+        if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            fprintf(stderr, "Failed to inflate: %s\n", r->z.msg ? r->z.msg : "corrupt data");
+            errno = EILSEQ;
+            return -1;
+        }
+
+        if (r->eof && r->z.avail_out == size) {
+            if (r->z.total_in) {
+                fprintf(stderr, "Failed to inflate: unexpected end of stream\n");
+                errno = EILSEQ;
+                return -1;
+            }
+            break;
+        }
+    }
+
+    return (ptrdiff_t)(size - r->z.avail_out);
+}
+#endif
+
+#if defined(BGL_HAVE_ZSTD)
+static ptrdiff_t read_zstd(bgl_reader r, void *buf, size_t size) {
+    ZSTD_outBuffer out = {buf, size, 0};
+
+    while (!out.pos) {
+        if (fill_input(r) < 0)
+            return -1;
+
+        ZSTD_inBuffer in = {r->in, r->in_len, r->in_pos};
+        size_t ret = ZSTD_decompressStream(r->zs, &out, &in);
+        r->in_pos = in.pos;
+
+        if (ZSTD_isError(ret)) {
+            fprintf(stderr, "Failed to decompress: %s\n", ZSTD_getErrorName(ret));
+            errno = EILSEQ;
+            return -1;
+        }
+        if (!r->eof)
+            r->zs_hint = ret;
+
+        if (r->eof && !out.pos) {
+            if (r->zs_hint) {
+                fprintf(stderr, "Failed to decompress: unexpected end of stream\n");
+                errno = EILSEQ;
+                return -1;
+            }
+            break;
+        }
+    }
+
+    return (ptrdiff_t)out.pos;
+}
+#endif
+
+/*!
+ * @brief Wrap a read callback, detecting gzip and zstd input by its magic.
+ */
+bgl_reader open_reader(bgl_read_fn read, void *user) {
+    bgl_reader r = calloc(1, sizeof(*r));
+    ptrdiff_t n = 0;
+
+    if (!(r && (r->in = malloc(READER_IN_SIZE)))) {
+        free(r);
+        return NULL;
+    }
+
+    r->read = read;
+    r->user = user;
+    memset(r->in, 0, 4);
+
+    // the magic stays in the input buffer and is consumed by the decoder or the caller
+    while (r->in_len < 4 && (n = read(user, &r->in[r->in_len], 4 - r->in_len)) > 0)
+        r->in_len += (size_t)n;
+    if (n < 0) {
+        close_reader(r);
+        return NULL;
+    }
+
+    if (r->in_len >= 2 && r->in[0] == 0x1F && r->in[1] == 0x8B)
+        r->codec = CODEC_GZIP;
+    else if (r->in_len >= 4 && !memcmp(r->in, "\x28\xB5\x2F\xFD", 4))
+        r->codec = CODEC_ZSTD;
+
+    switch (r->codec) {
+    case CODEC_GZIP:
+#if defined(BGL_HAVE_ZLIB)
+        if (inflateInit2(&r->z, 15 + 32) != Z_OK) {
+            errno = ENOMEM;
+            break;
+        }
+        return r;
+#else
+        fprintf(stderr, "Failed to open input: gzip support is not built in\n");
+        errno = ENOTSUP;
+        break;
+#endif
+    case CODEC_ZSTD:
+#if defined(BGL_HAVE_ZSTD)
+        if (!(r->zs = ZSTD_createDStream()) || ZSTD_isError(ZSTD_initDStream(r->zs))) {
+            errno = ENOMEM;
+            break;
+        }
+        return r;
+#else
+        fprintf(stderr, "Failed to open input: zstd support is not built in\n");
+        errno = ENOTSUP;
+        break;
+#endif
+    default:
+        return r;
+    }
+
+    close_reader(r);
+
+    return NULL;
+}
+
+ptrdiff_t reader_read(bgl_reader r, void *buf, size_t size) {
+    switch (r->codec) {
+#if defined(BGL_HAVE_ZLIB)
+    case CODEC_GZIP:
+        return read_gzip(r, buf, size);
+#endif
+#if defined(BGL_HAVE_ZSTD)
+    case CODEC_ZSTD:
+        return read_zstd(r, buf, size);
+#endif
+    default:
+        // plain input, hand out what is left of the peeked magic first
+        if (r->in_pos < r->in_len) {
+            size_t n = r->in_len - r->in_pos < size ? r->in_len - r->in_pos : size;
+            memcpy(buf, &r->in[r->in_pos], n);
+            r->in_pos += n;
+            return (ptrdiff_t)n;
+        }
+        return r->read(r->user, buf, size);
+    }
+}
+
+/*!
+ * @brief Read the whole decoded input into one buffer, NUL terminated.
+ */
+char *reader_read_all(bgl_reader r, size_t *size) {
+    size_t cap = READER_IN_SIZE, len = 0;
+    char *buf = malloc(cap + 1);
+    ptrdiff_t n = 0;
+
+    if (!buf)
+        return NULL;
+
+    while ((n = reader_read(r, &buf[len], cap - len)) > 0) {
+        if ((len += (size_t)n) == cap) {
+            char *p = realloc(buf, (cap <<= 1) + 1);
+            if (!p) {
+                free(buf);
+                return NULL;
+            }
+            buf = p;
+        }
+    }
+    if (n < 0) {
+        free(buf);
+        return NULL;
+    }
+
+    buf[len] = '\0';
+    *size = len;
+
+    return buf;
+}
+
+int reader_is_compressed(bgl_reader r) {
+    return r->codec != CODEC_NONE;
+}
+
+void close_reader(bgl_reader r) {
+#if defined(BGL_HAVE_ZLIB)
+    if (r->codec == CODEC_GZIP)
+        inflateEnd(&r->z);
+#endif
+#if defined(BGL_HAVE_ZSTD)
+    if (r->zs)
+        ZSTD_freeDStream(r->zs);
+#endif
+    free(r->in);
+    free(r);
+}
+
+ptrdiff_t read_stdio(void *user, void *buf, size_t size) {
+    size_t n = fread(buf, 1, size, user);
+
+    if (!n && ferror((FILE *)user)) {
+        errno = errno ? : EIO;
+        return -1;
+    }
+
+    return (ptrdiff_t)n;
+}
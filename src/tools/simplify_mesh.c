@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <errno.h>
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <bgl/bglt.h>
+
+#include "internal.h"
+
+
+typedef struct {
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double w;
+} quadric;
+
+typedef struct {
+    int from;
+    int to;
+    float cost;
+} collapse;
+
+static void quadric_from_triangle(quadric *q, const float *p0, const float *p1, const float *p2) {
+    vec3 u, v, n;
+
+    glm_vec3_sub((float *)p1, (float *)p0, u);
+    glm_vec3_sub((float *)p2, (float *)p0, v);
+    glm_vec3_cross(u, v, n);
+
+    double area = glm_vec3_norm(n) * 0.5;
+    glm_vec3_normalize(n);
+    double d = -glm_vec3_dot(n, (float *)p0);
+
+    q->a00 = area * n[0] * n[0];
+    q->a01 = area * n[0] * n[1];
+    q->a02 = area * n[0] * n[2];
+    q->a11 = area * n[1] * n[1];
+    q->a12 = area * n[1] * n[2];
+    q->a22 = area * n[2] * n[2];
+    q->b0 = area * n[0] * d;
+    q->b1 = area * n[1] * d;
+    q->b2 = area * n[2] * d;
+    q->c = area * d * d;
+    q->w = area;
+}
+
+static void quadric_add(quadric *dst, const quadric *q) {
+    dst->a00 += q->a00;
+    dst->a01 += q->a01;
+    dst->a02 += q->a02;
+    dst->a11 += q->a11;
+    dst->a12 += q->a12;
+    dst->a22 += q->a22;
+    dst->b0 += q->b0;
+    dst->b1 += q->b1;
+    dst->b2 += q->b2;
+    dst->c += q->c;
+    dst->w += q->w;
+}
+
+/*!
+ * @brief Mean squared distance from p to the planes accumulated in qa and qb.
+ */
+static float quadric_error(const quadric *qa, const quadric *qb, const float *p) {
+    double x = p[0], y = p[1], z = p[2];
+    double a00 = qa->a00 + qb->a00, a01 = qa->a01 + qb->a01, a02 = qa->a02 + qb->a02;
+    double a11 = qa->a11 + qb->a11, a12 = qa->a12 + qb->a12, a22 = qa->a22 + qb->a22;
+    double w = qa->w + qb->w;
+
+    double e = x * x * a00 + y * y * a11 + z * z * a22
+               + 2 * (x * y * a01 + x * z * a02 + y * z * a12)
+               + 2 * (x * (qa->b0 + qb->b0) + y * (qa->b1 + qb->b1) + z * (qa->b2 + qb->b2))
+               + qa->c + qb->c;
+
+    return w > 0 ? (float)fabs(e / w) : 0;
+}
+
+static int cmp_collapse(const collapse *a, const collapse *b) {
+    return (a->cost > b->cost) - (a->cost < b->cost);
+}
+
+static uint32_t hash_edge(int a, int b) {
+    return ((uint32_t)a * 73856093u) ^ ((uint32_t)b * 19349663u);
+}
+
+/*!
+ * @brief Lock vertices on open borders, so the silhouette of open meshes survives.
+ */
+static int find_border(const vindex *indices, int i_cnt, char *locked) {
+    size_t table_sz = 1;
+    int (*table)[3];
+
+    while (table_sz < (size_t)i_cnt * 2)
+        table_sz <<= 1;
+
+    if (!(table = malloc(table_sz * sizeof(*table))))
+        return false;
+    memset(table, 0xFF, table_sz * sizeof(*table));
+
+    for (int i = 0; i < i_cnt; ++i) {
+        int a = indices[i].idx, b = indices[i - i % 3 + (i + 1) % 3].idx;
+        if (a > b)
+            a ^= b, b ^= a, a ^= b;
+
+        size_t slot = hash_edge(a, b) & (table_sz - 1);
+        while (table[slot][0] >= 0 && !(table[slot][0] == a && table[slot][1] == b))
+            slot = (slot + 1) & (table_sz - 1);
+
+        if (table[slot][0] < 0) {
+            table[slot][0] = a;
+            table[slot][1] = b;
+            table[slot][2] = 0;
+        }
+        ++table[slot][2];
+    }
+
+    for (size_t s = 0; s < table_sz; ++s) {
+        if (table[s][0] >= 0 && table[s][2] == 1)
+            locked[table[s][0]] = locked[table[s][1]] = 1;
+    }
+
+    free(table);
+
+    return true;
+}
+
+static int flips(const vertex *vertices, const vindex *indices, const int *offsets, const int *adjacency,
+                 int from, int to) {
+    for (const int *adj = &adjacency[offsets[from]]; adj < &adjacency[offsets[from + 1]]; ++adj) {
+        const vindex *tri = &indices[*adj * 3];
+        int k = tri[0].idx == from ? 0 : tri[1].idx == from ? 1 : 2;
+        int a = tri[(k + 1) % 3].idx, b = tri[(k + 2) % 3].idx;
+        vec3 u, v, n0, n1;
+
+        if (a == to || b == to)
+            continue;   // collapses into a degenerate triangle
+
+        glm_vec3_sub((float *)vertices[a].pos, (float *)vertices[from].pos, u);
+        glm_vec3_sub((float *)vertices[b].pos, (float *)vertices[from].pos, v);
+        glm_vec3_cross(u, v, n0);
+        glm_vec3_sub((float *)vertices[a].pos, (float *)vertices[to].pos, u);
+        glm_vec3_sub((float *)vertices[b].pos, (float *)vertices[to].pos, v);
+        glm_vec3_cross(u, v, n1);
+
+        if (glm_vec3_dot(n0, n1) <= 0)
+            return true;
+    }
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BGL_API int bgl_simplify_mesh(const vertex *vertices, int v_cnt, const vindex *indices, int i_cnt,
+                              vindex *dst, int target_i_cnt, float target_error, float *result_error) {
+    quadric *quadrics = calloc(v_cnt + 1, sizeof(*quadrics));
+    char *locked = calloc(v_cnt + 1, sizeof(*locked));
+    char *touched = malloc(v_cnt + 1);
+    int *remap = malloc((v_cnt + 1) * sizeof(*remap));
+    int *offsets = malloc((v_cnt + 2) * sizeof(*offsets));
+    int *adjacency = malloc((i_cnt + 1) * sizeof(*adjacency));
+    collapse *collapses = malloc((i_cnt + 1) * sizeof(*collapses));
+    float max_error = 0, limit = target_error * target_error;
+    int cnt = -1;
+
+    i_cnt -= i_cnt % 3;
+    if (result_error)
+        *result_error = 0;
+
+    if (!(quadrics && locked && touched && remap && offsets && adjacency && collapses))
+        goto end;
+
+    for (int i = 0; i < i_cnt; ++i) {
+        if (indices[i].idx < 0 || indices[i].idx >= v_cnt) {
+            errno = EINVAL;
+            goto end;
+        }
+    }
+
+    if (dst != indices)
+        memmove(dst, indices, i_cnt * sizeof(*dst));
+    cnt = i_cnt;
+
+    for (int i = 0; i < cnt; i += 3) {
+        quadric q;
+        quadric_from_triangle(&q, vertices[dst[i].idx].pos, vertices[dst[i + 1].idx].pos, vertices[dst[i + 2].idx].pos);
+        for (int k = 0; k < 3; ++k)
+            quadric_add(&quadrics[dst[i + k].idx], &q);
+    }
+
+    if (!find_border(dst, cnt, locked)) {
+        cnt = -1;
+        goto end;
+    }
+
+    while (cnt > target_i_cnt) {
+        int collapse_cnt = 0, tris = cnt / 3, applied = 0;
+
+        // vertex to triangle adjacency of the current mesh
+        memset(offsets, 0, (v_cnt + 2) * sizeof(*offsets));
+        for (int i = 0; i < cnt; ++i)
+            ++offsets[dst[i].idx + 2];
+        for (int v = 0; v < v_cnt; ++v)
+            offsets[v + 2] += offsets[v + 1];
+        for (int i = 0; i < cnt; ++i)
+            adjacency[offsets[dst[i].idx + 1]++] = i / 3;
+
+        // one candidate per edge, in the cheaper direction
+        for (int i = 0; i < cnt; ++i) {
+            int a = dst[i].idx, b = dst[i - i % 3 + (i + 1) % 3].idx;
+            float ea, eb;
+
+            if (a >= b || (locked[a] && locked[b]))
+                continue;
+
+            ea = locked[a] ? FLT_MAX : quadric_error(&quadrics[a], &quadrics[b], vertices[b].pos);
+            eb = locked[b] ? FLT_MAX : quadric_error(&quadrics[a], &quadrics[b], vertices[a].pos);
+
+            collapses[collapse_cnt].from = ea <= eb ? a : b;
+            collapses[collapse_cnt].to = ea <= eb ? b : a;
+            collapses[collapse_cnt++].cost = ea <= eb ? ea : eb;
+        }
+
+        qsort(collapses, collapse_cnt, sizeof(*collapses), (int (*)(const void *, const void *))cmp_collapse);
+
+        for (int v = 0; v < v_cnt; ++v)
+            remap[v] = v;
+        memset(touched, 0, v_cnt);
+
+        for (collapse *c = collapses; c < &collapses[collapse_cnt] && tris * 3 > target_i_cnt; ++c) {
+            if (c->cost > limit)
+                break;
+            if (touched[c->from] || touched[c->to])
+                continue;
+            if (flips(vertices, dst, offsets, adjacency, c->from, c->to))
+                continue;
+
+            // triangles sharing the edge disappear
+            for (int *adj = &adjacency[offsets[c->from]]; adj < &adjacency[offsets[c->from + 1]]; ++adj) {
+                const vindex *tri = &dst[*adj * 3];
+                if (tri[0].idx == c->to || tri[1].idx == c->to || tri[2].idx == c->to)
+                    --tris;
+            }
+
+            // keep neighbourhoods of this pass independent
+            for (int *adj = &adjacency[offsets[c->from]]; adj < &adjacency[offsets[c->from + 1]]; ++adj)
+                for (int k = 0; k < 3; ++k)
+                    touched[dst[*adj * 3 + k].idx] = 1;
+
+            remap[c->from] = c->to;
+            quadric_add(&quadrics[c->to], &quadrics[c->from]);
+            max_error = glm_max(max_error, c->cost);
+            ++applied;
+        }
+
+        if (!applied)
+            break;
+
+        int n = 0;
+        for (int i = 0; i < cnt; i += 3) {
+            int a = remap[dst[i].idx], b = remap[dst[i + 1].idx], c = remap[dst[i + 2].idx];
+            if (a == b || b == c || c == a)
+                continue;
+
+            dst[n] = dst[i];
+            dst[n + 1] = dst[i + 1];
+            dst[n + 2] = dst[i + 2];
+            dst[n].idx = a;
+            dst[n + 1].idx = b;
+            dst[n + 2].idx = c;
+            n += 3;
+        }
+        cnt = n;
+    }
+
+    if (result_error)
+        *result_error = sqrtf(max_error);
+
+end:
+    free(quadrics);
+    free(locked);
+    free(touched);
+    free(remap);
+    free(offsets);
+    free(adjacency);
+    free(collapses);
+
+    return cnt;
+}
+
+BGL_API int bgl_generate_lod(bgl_instance bgl, int vbuf_id, const vertex *vertices, int v_cnt,
+                             const vindex *indices, int i_cnt, int levels, float ratio) {
+    int *ids = malloc((levels > 0 ? levels : 1) * sizeof(*ids));
+    float *errors = malloc((levels > 0 ? levels : 1) * sizeof(*errors));
+    vindex *level = bgl_aligned_alloc(16, (i_cnt > 0 ? i_cnt : 1) * sizeof(*level));
+    int cnt = 0, prev = i_cnt, lod = -1;
+    float target = (float)i_cnt;
+
+    if (!(ids && errors && level)) {
+        fprintf(stderr, "Failed to generate LOD: %s\n", strerror(errno));
+        goto end;
+    }
+
+    if ((ids[cnt] = bgl_create_index_buffer(bgl, vbuf_id, indices, i_cnt, BGL_TRIANGLES)) < 0)
+        goto end;
+    errors[cnt++] = 0;
+
+    // every level is simplified from the source, so errors do not stack
+    while (cnt < levels) {
+        int n;
+
+        target *= ratio;
+        if ((n = bgl_simplify_mesh(vertices, v_cnt, indices, i_cnt, level, (int)target, FLT_MAX, &errors[cnt])) < 0) {
+            fprintf(stderr, "Failed to generate LOD: %s\n", strerror(errno));
+            break;
+        }
+        if (!n || n >= prev)
+            break;
+
+        if ((ids[cnt] = bgl_create_index_buffer(bgl, vbuf_id, level, n, BGL_TRIANGLES)) < 0)
+            break;
+        ++cnt;
+        prev = n;
+    }
+
+    if ((lod = bgl_create_lod(bgl, ids, errors, cnt)) < 0)
+        while (cnt--)
+            bgl_remove_index_buffer(bgl, ids[cnt], false);
+
+end:
+    free(ids);
+    free(errors);
+    bgl_aligned_free(level);
+
+    return lod;
+}
@@ -12,11 +12,21 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
 
 #if defined _WIN32 || defined __CYGWIN__
 #else
 #endif
 
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+# define BGL_BIG_ENDIAN 1
+#else
+# define BGL_BIG_ENDIAN 0
+#endif
+
 
 BGL_INLINE void *bgl_aligned_alloc(size_t alignment, size_t size) {
 #if defined _WIN32 || defined __CYGWIN__
@@ -67,4 +77,75 @@ BGL_INLINE char *bgl_strndup(const char *string, size_t n) {
 #endif
 }
 
+/*!
+ * @brief Convert a normalized RGBA color to packed ARGB, clamping each channel.
+ */
+BGL_INLINE uint32_t bgl_vec4_to_argb(const float *color) {
+#if defined(__SSE2__)
+    __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(color), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    __m128i i = _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(255.0f)));
+    i = _mm_packs_epi32(i, i);
+    i = _mm_packus_epi16(i, i);
+    uint32_t rgba = (uint32_t)_mm_cvtsi128_si32(i);     // bytes r, g, b, a
+    return (rgba & 0xFF00FF00u) | (rgba >> 16 & 0xFF) | (rgba & 0xFF) << 16;
+#else
+    uint32_t argb = 0;
+    for (int k = 0; k < 4; ++k) {
+        float c = color[k] < 0 ? 0 : color[k] > 1 ? 1 : color[k];
+        argb |= (uint32_t)(c * 255.0f + 0.5f) << (k == 3 ? 24 : 16 - k * 8);
+    }
+    return argb;
+#endif
+}
+
+/*!
+ * @brief Unaligned loads from file data, `swap` when its byte order differs from the host.
+ */
+BGL_INLINE uint16_t bgl_load_u16(const void *p, int swap) {
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return swap ? (uint16_t)(v >> 8 | v << 8) : v;
+}
+
+BGL_INLINE uint32_t bgl_bswap32(uint32_t v) {
+    return v >> 24 | (v >> 8 & 0xFF00) | (v & 0xFF00) << 8 | v << 24;
+}
+
+BGL_INLINE uint32_t bgl_load_u32(const void *p, int swap) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return swap ? bgl_bswap32(v) : v;
+}
+
+BGL_INLINE uint64_t bgl_load_u64(const void *p, int swap) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return swap ? (uint64_t)bgl_bswap32((uint32_t)v) << 32 | bgl_bswap32((uint32_t)(v >> 32)) : v;
+}
+
+BGL_INLINE float bgl_load_f32(const void *p, int swap) {
+    uint32_t v = bgl_load_u32(p, swap);
+    float f;
+    memcpy(&f, &v, sizeof(f));
+    return f;
+}
+
+BGL_INLINE double bgl_load_f64(const void *p, int swap) {
+    uint64_t v = bgl_load_u64(p, swap);
+    double d;
+    memcpy(&d, &v, sizeof(d));
+    return d;
+}
+
+/*!
+ * @brief Busy wait hint, eases the spin on the sibling hyperthread.
+ */
+BGL_INLINE void bgl_cpu_relax(void) {
+#if defined(__SSE2__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
 #endif // BGL_UTILS_H
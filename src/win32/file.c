@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <errno.h>
+
+#include <bgl/bgl.h>
+
+#include "internal.h"
+
+
+void *map_platform_file(const char *path, size_t *size) {
+    LARGE_INTEGER sz;
+    HANDLE mapping;
+    void *data = NULL;
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if (file == INVALID_HANDLE_VALUE) {
+        errno = ENOENT;
+        return NULL;
+    }
+
+    if (!GetFileSizeEx(file, &sz)) {
+        errno = EIO;
+        goto end;
+    }
+
+    // a zero length mapping is rejected, an empty file maps to an empty string
+    if (!(*size = (size_t)sz.QuadPart)) {
+        data = "";
+        goto end;
+    }
+
+    if ((mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL))) {
+        data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+    }
+    if (!data)
+        errno = ENOMEM;
+
+end:
+    CloseHandle(file);
+
+    return data;
+}
+
+void unmap_platform_file(void *data, size_t size) {
+    if (size)
+        UnmapViewOfFile(data);
+}
+
+int stat_platform_file(const char *path, uint64_t *size, int64_t *mtime) {
+    WIN32_FILE_ATTRIBUTE_DATA attr;
+
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attr)) {
+        errno = ENOENT;
+        return false;
+    }
+
+    *size = (uint64_t)attr.nFileSizeHigh << 32 | attr.nFileSizeLow;
+    // 100 ns intervals
+    *mtime = (int64_t)((uint64_t)attr.ftLastWriteTime.dwHighDateTime << 32 | attr.ftLastWriteTime.dwLowDateTime) * 100;
+
+    return true;
+}
+
+/*!
+ * @brief Move from over to; fails while to is mapped, which leaves to untouched.
+ */
+int replace_platform_file(const char *from, const char *to) {
+    if (!MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING)) {
+        errno = EACCES;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022 Alexander Baskikh
+ *
+ * MIT License (MIT), http://opensource.org/licenses/MIT
+ * Full license can be found in the LICENSE file
+ */
+
+#include <stdlib.h>
+
+#include <bgl/bgl.h>
+
+#include "internal.h"
+
+
+typedef struct {
+    void (*fn)(void *arg);
+    void *arg;
+} thread_start;
+
+static DWORD WINAPI thread_main(LPVOID arg) {
+    thread_start start = *(thread_start *)arg;
+
+    free(arg);
+    start.fn(start.arg);
+
+    return 0;
+}
+
+int create_platform_thread(bgl_platform_thread *thread, void (*fn)(void *arg), void *arg) {
+    thread_start *start = malloc(sizeof(*start));
+
+    if (!start)
+        return false;
+
+    start->fn = fn;
+    start->arg = arg;
+    if (!(*thread = CreateThread(NULL, 0, thread_main, start, 0, NULL))) {
+        free(start);
+        return false;
+    }
+
+    return true;
+}
+
+void join_platform_thread(bgl_platform_thread thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+int get_platform_cpu_count(void) {
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+int init_platform_mutex(bgl_platform_mutex *mutex) {
+    InitializeCriticalSection(mutex);
+    return true;
+}
+
+void destroy_platform_mutex(bgl_platform_mutex *mutex) {
+    DeleteCriticalSection(mutex);
+}
+
+void lock_platform_mutex(bgl_platform_mutex *mutex) {
+    EnterCriticalSection(mutex);
+}
+
+void unlock_platform_mutex(bgl_platform_mutex *mutex) {
+    LeaveCriticalSection(mutex);
+}
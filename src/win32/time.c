@@ -23,3 +23,11 @@ uint64_t get_platform_timer_value(bgl_instance bgl) {
 uint64_t get_platform_timer_freq(bgl_instance bgl) {
     return bgl->timer.freq;
 }
+
+void sleep_platform_timer_until(bgl_instance bgl, uint64_t deadline) {
+    uint64_t now = get_platform_timer_value(bgl), freq = get_platform_timer_freq(bgl);
+
+    // Sleep granularity is the scheduler tick, the caller spins the rest
+    if (freq && deadline > now)
+        Sleep((DWORD)((deadline - now) * 1000 / freq));
+}
@@ -47,6 +47,24 @@ static LRESULT CALLBACK window_proc_callback(HWND h_wnd, UINT u_msg, WPARAM w_pa
         input_window_close_request(bgl);
         return 0;
 
+    case WM_SIZE:
+    {
+        bgl_platform_window *w32w = &bgl->window->platform;
+        int old_width = w32w->width, old_height = w32w->height;
+        int width = LOWORD(l_param), height = HIWORD(l_param);
+
+        // minimizing reports 0x0, keep the last real size
+        if (w_param == SIZE_MINIMIZED || (width == old_width && height == old_height))
+            break;
+        if (bgl->dev.resize_framebuffer && !bgl->dev.resize_framebuffer(bgl, width, height))
+            break;
+
+        w32w->width = width;
+        w32w->height = height;
+        input_window_resize(bgl, old_width, old_height, width, height);
+        return 0;
+    }
+
     default:
         break;
     }
@@ -213,6 +231,17 @@ int is_visible_platform_window(bgl_instance bgl) {
     return IsWindowVisible(bgl->window->platform.window);
 }
 
+void get_platform_window_size(bgl_instance bgl, int *width, int *height) {
+    if (width)
+        *width = bgl->window->platform.width;
+    if (height)
+        *height = bgl->window->platform.height;
+}
+
+void get_platform_framebuffer_size(bgl_instance bgl, int *width, int *height) {
+    get_platform_window_size(bgl, width, height);
+}
+
 
 /// window events
 
@@ -244,7 +273,8 @@ void poll_platform_window_events(bgl_instance bgl) {
                     || (bgl->window->keys[key].action != BGL_PRESS))
                 continue;
 
-            input_key(bgl, key, bgl->platform.scancodes[key], BGL_PRESS, get_key_mods());
+            input_key(bgl, key, bgl->platform.scancodes[key], BGL_PRESS, get_key_mods(),
+                      get_platform_timer_value(bgl));
         }
     }
 }
@@ -260,5 +290,19 @@ void wait_platform_window_events_timeout(bgl_instance bgl, double t) {
 }
 
 void send_platform_window_empty_event(bgl_instance bgl) {
-    PostMessageW(bgl->window->platform.window, WM_NULL, 0, 0);
+    if (bgl->window)
+        PostMessageW(bgl->window->platform.window, WM_NULL, 0, 0);
+}
+
+int watch_platform_fd(bgl_instance bgl, int fd, bgl_fd_events events, bgl_fd_fn callback, void *user) {
+    fprintf(stderr, "Win32: fd watches are not supported\n");
+    return false;
+}
+
+int unwatch_platform_fd(bgl_instance bgl, int fd) {
+    return false;
+}
+
+int get_platform_event_fd(bgl_instance bgl) {
+    return -1;
 }
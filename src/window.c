@@ -55,6 +55,7 @@ BGL_API void bgl_destroy_window(bgl_instance bgl) {
 
     destroy_platform_window(bgl);
 
+    free(bgl->window->queue.items);
     free(bgl->window);
     bgl->window = NULL;
 }
@@ -100,20 +101,131 @@ BGL_API void bgl_set_window_title(bgl_instance bgl, const char *title) {
     set_platform_window_title(bgl, title);
 }
 
+/*!
+ * @brief Whether windows created afterwards can be resized by the user.
+ */
+BGL_API void bgl_set_window_resizable(bgl_instance bgl, int val) {
+    bgl->default_cfgs.window.resizable = val;
+}
+
+BGL_API void bgl_get_window_size(bgl_instance bgl, int *width, int *height) {
+    if (!bgl->window) {
+        fprintf(stderr, "Invalid window\n");
+        if (width)
+            *width = 0;
+        if (height)
+            *height = 0;
+        return;
+    }
+
+    get_platform_window_size(bgl, width, height);
+}
+
+/*!
+ * @brief Size of the render target, it lags the window size until the next event poll.
+ */
+BGL_API void bgl_get_framebuffer_size(bgl_instance bgl, int *width, int *height) {
+    if (!bgl->window) {
+        fprintf(stderr, "Invalid window\n");
+        if (width)
+            *width = 0;
+        if (height)
+            *height = 0;
+        return;
+    }
+
+    get_platform_framebuffer_size(bgl, width, height);
+}
+
 BGL_API void bgl_swap_buffers(bgl_instance bgl) {
     if (bgl->dev.swap_buffers)
         bgl->dev.swap_buffers(bgl);
+    record_frame_time(bgl);
 }
 
 
 /// events
 
+/*!
+ * @brief Last state of a key as of the latest event poll, repeats report as BGL_PRESS.
+ */
+BGL_API bgl_key_action bgl_get_key(bgl_instance bgl, bgl_key key) {
+    if (!bgl->window || key < 0 || key >= BGL_KEY_MAX)
+        return BGL_RELEASE;
+
+    return bgl->window->keys[key].action;
+}
+
+/*!
+ * @brief When the key last changed state, in timer ticks, 0 if it never did.
+ */
+BGL_API uint64_t bgl_get_key_time(bgl_instance bgl, bgl_key key) {
+    if (!bgl->window || key < 0 || key >= BGL_KEY_MAX)
+        return 0;
+
+    return bgl->window->keys[key].time;
+}
+
+/*!
+ * @brief Keep up to `capacity` events for bgl_get_events, callbacks still run. 0 turns the queue off.
+ * Pending events are dropped.
+ */
+BGL_API int bgl_set_event_queue(bgl_instance bgl, int capacity) {
+    if (!bgl->window) {
+        fprintf(stderr, "Invalid window\n");
+        return false;
+    }
+    if (capacity < 0) {
+        fprintf(stderr, "Invalid event queue capacity: %d\n", capacity);
+        return false;
+    }
+
+    typeof(bgl->window->queue) *q = &bgl->window->queue;
+    bgl_event *items = NULL;
+
+    if (capacity && !(items = malloc(capacity * sizeof(*items)))) {
+        fprintf(stderr, "Failed to create event queue: %s\n", strerror(errno));
+        return false;
+    }
+
+    free(q->items);
+    *q = (typeof(*q)){.items = items, .cap = capacity};
+
+    return true;
+}
+
+/*!
+ * @brief Move up to `max` queued events, oldest first, into `events`.
+ * @return Number of events moved.
+ */
+BGL_API int bgl_get_events(bgl_instance bgl, bgl_event *events, int max) {
+    if (!bgl->window)
+        return 0;
+
+    typeof(bgl->window->queue) *q = &bgl->window->queue;
+    int n = q->cnt < max ? q->cnt : max;
+    if (n <= 0)
+        return 0;
+
+    // at most two runs, split where the ring wraps
+    int first = q->cap - q->head < n ? q->cap - q->head : n;
+    memcpy(events, &q->items[q->head], first * sizeof(*events));
+    memcpy(&events[first], q->items, (n - first) * sizeof(*events));
+
+    q->head = q->cap ? (q->head + n) % q->cap : 0;
+    q->cnt -= n;
+
+    return n;
+}
+
 BGL_API void bgl_poll_events(bgl_instance bgl) {
     poll_platform_window_events(bgl);
+    dispatch_loaded_objs(bgl);
 }
 
 BGL_API void bgl_wait_events(bgl_instance bgl) {
     wait_platform_window_events(bgl);
+    dispatch_loaded_objs(bgl);
 }
 
 BGL_API void bgl_wait_events_timeout(bgl_instance bgl, double t) {
@@ -123,16 +235,57 @@ BGL_API void bgl_wait_events_timeout(bgl_instance bgl, double t) {
     }
 
     wait_platform_window_events_timeout(bgl, t);
+    dispatch_loaded_objs(bgl);
 }
 
 BGL_API void bgl_send_empty_event(bgl_instance bgl) {
     send_platform_window_empty_event(bgl);
 }
 
+/*!
+ * @brief Share the event wait with a user fd, its callback runs from the event functions when it is ready.
+ * The fd is level triggered, so the callback has to consume what made it ready.
+ * Watching an already watched fd replaces its events and callback.
+ */
+BGL_API int bgl_watch_fd(bgl_instance bgl, int fd, bgl_fd_events events, bgl_fd_fn callback, void *user) {
+    if (fd < 0 || !callback || !(events & (BGL_FD_READ | BGL_FD_WRITE))) {
+        fprintf(stderr, "watch_fd: Invalid fd %d or no events\n", fd);
+        return false;
+    }
+
+    return watch_platform_fd(bgl, fd, events, callback, user);
+}
+
+BGL_API int bgl_unwatch_fd(bgl_instance bgl, int fd) {
+    return unwatch_platform_fd(bgl, fd);
+}
+
+/*!
+ * @brief Fd that becomes readable when the event functions have work, for nesting BGL into another poll loop.
+ * @return -1 when the platform has none.
+ */
+BGL_API int bgl_get_event_fd(bgl_instance bgl) {
+    return get_platform_event_fd(bgl);
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void input_key(bgl_instance bgl, bgl_key key, unsigned scancode, bgl_key_action action, bgl_key_mods mods) {
+static void push_event(bgl_instance bgl, const bgl_event *evt) {
+    typeof(bgl->window->queue) *q = &bgl->window->queue;
+
+    if (!q->cap)
+        return;
+
+    q->items[(q->head + q->cnt) % q->cap] = *evt;
+    if (q->cnt < q->cap)
+        ++q->cnt;
+    else
+        q->head = (q->head + 1) % q->cap;
+}
+
+void input_key(bgl_instance bgl, bgl_key key, unsigned scancode, bgl_key_action action, bgl_key_mods mods,
+               uint64_t time) {
     if (!bgl->window) {
         fprintf(stderr, "Invalid window");
         return;
@@ -148,14 +301,38 @@ void input_key(bgl_instance bgl, bgl_key key, unsigned scancode, bgl_key_action
 
         if (repeated)
             action = BGL_REPEATE;
+        else
+            bgl->window->keys[key].time = time;
     }
 
+    push_event(bgl, &(bgl_event){.type = BGL_EVENT_KEY, .time = time,
+                                 .key = {key, scancode, action, mods}});
+
     if (bgl->window->callbacks.key)
         (*bgl->window->callbacks.key)(bgl, key, scancode, action, mods);
 }
 
 void input_window_close_request(bgl_instance bgl) {
     bgl->window->should_close = true;
+    push_event(bgl, &(bgl_event){.type = BGL_EVENT_CLOSE, .time = get_platform_timer_value(bgl)});
     if (bgl->window->callbacks.close)
         (*bgl->window->callbacks.close)(bgl);
 }
+
+/*!
+ * @brief The framebuffer already has the new size. The viewport keeps its place relative to the window, flips included.
+ */
+void input_window_resize(bgl_instance bgl, int old_width, int old_height, int width, int height) {
+    bgl_viewport vp = bgl->viewport.src;
+
+    if (vp.width != 0 && vp.height != 0 && old_width > 0 && old_height > 0) {
+        float sx = (float)width / (float)old_width, sy = (float)height / (float)old_height;
+        bgl_set_viewport(bgl, &(bgl_viewport){vp.x * sx, vp.y * sy, vp.width * sx, vp.height * sy});
+    }
+
+    push_event(bgl, &(bgl_event){.type = BGL_EVENT_RESIZE, .time = get_platform_timer_value(bgl),
+                                 .size = {width, height}});
+
+    if (bgl->window->callbacks.resize)
+        (*bgl->window->callbacks.resize)(bgl, width, height);
+}
@@ -13,6 +13,11 @@
 #include <string.h>
 #include <unistd.h>
 
+#if defined(__linux__)
+# include <sys/epoll.h>
+# include <sys/eventfd.h>
+#endif
+
 #include "internal.h"
 
 
@@ -325,10 +330,56 @@ static void create_key_tables(bgl_instance bgl) {
     XFree(keysyms);
 }
 
+static int create_wake_fds(bgl_instance bgl) {
+#if defined(__linux__)
+    int efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (efd != -1) {
+        bgl->platform.wake_rd = bgl->platform.wake_wr = efd;
+        return true;
+    }
+#endif
+
+    if (pipe(bgl->platform.wake_fds)) {
+        fprintf(stderr, "X11: Failed to create empty event pipe: %s\n", strerror(errno));
+        bgl->platform.wake_rd = bgl->platform.wake_wr = -1;
+        return false;
+    }
+    for (int i = 0; i < 2; ++i) {
+        const int fl = fcntl(bgl->platform.wake_fds[i], F_GETFL, 0);
+        const int fd = fcntl(bgl->platform.wake_fds[i], F_GETFD, 0);
+        if (fl == -1 || fd == -1
+            || fcntl(bgl->platform.wake_fds[i], F_SETFL, fl | O_NONBLOCK) == -1
+            || fcntl(bgl->platform.wake_fds[i], F_SETFD, fd | FD_CLOEXEC) == -1) {
+            fprintf(stderr, "X11: Failed to set flags for empty event pipe: %s\n", strerror(errno));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int create_wait_set(bgl_instance bgl) {
+#if defined(__linux__)
+    struct epoll_event x11_evt = {.events = EPOLLIN, .data.fd = ConnectionNumber(bgl->platform.display)};
+    struct epoll_event wake_evt = {.events = EPOLLIN, .data.fd = bgl->platform.wake_rd};
+
+    if ((bgl->platform.epoll_fd = epoll_create1(EPOLL_CLOEXEC)) == -1
+        || epoll_ctl(bgl->platform.epoll_fd, EPOLL_CTL_ADD, x11_evt.data.fd, &x11_evt)
+        || epoll_ctl(bgl->platform.epoll_fd, EPOLL_CTL_ADD, wake_evt.data.fd, &wake_evt)) {
+        fprintf(stderr, "X11: Failed to create epoll set: %s\n", strerror(errno));
+        return false;
+    }
+#endif
+
+    return true;
+}
+
 int init_platform(bgl_instance bgl) {
 //    XInitThreads();
 //    XrmInitialize();
 
+    bgl->platform.wake_rd = bgl->platform.wake_wr = bgl->platform.epoll_fd = -1;
+
     if (!(bgl->platform.display = XOpenDisplay(NULL))) {
         fprintf(stderr, "X11: Failed to open display: %s\n",
                 getenv("DISPLAY") ?: "`DISPLAY` environment is missing");
@@ -339,20 +390,8 @@ int init_platform(bgl_instance bgl) {
     bgl->platform.root = XRootWindow(bgl->platform.display, bgl->platform.screen);
     bgl->platform.context = XUniqueContext();
 
-    if (pipe(bgl->platform.empty_evt_pipe)) {
-        fprintf(stderr, "X11: Failed to create empty event pipe: %s\n", strerror(errno));
+    if (!create_wake_fds(bgl) || !create_wait_set(bgl))
         return false;
-    }
-    for (int i = 0; i < 2; ++i) {
-        const int fl = fcntl(bgl->platform.empty_evt_pipe[1], F_GETFL, 0);
-        const int fd = fcntl(bgl->platform.empty_evt_pipe[1], F_GETFD, 0);
-        if (fl == -1 || fd == -1
-            || fcntl(bgl->platform.empty_evt_pipe[i], F_SETFL, fl | O_NONBLOCK) == -1
-            || fcntl(bgl->platform.empty_evt_pipe[i], F_SETFL, fd | FD_CLOEXEC) == -1) {
-            fprintf(stderr, "X11: Failed to set flags for empty event pipe: %s\n", strerror(errno));
-            return false;
-        }
-    }
 
     // extensions
     XInternAtoms(bgl->platform.display,
@@ -368,17 +407,24 @@ int init_platform(bgl_instance bgl) {
 }
 
 void terminate_platform(bgl_instance bgl) {
-    bgl_platform x11 = bgl->platform;
+    bgl_platform *x11 = &bgl->platform;
 
-    if (x11.display) {
-        XCloseDisplay(x11.display);
-        x11.display = NULL;
+    if (x11->display) {
+        XCloseDisplay(x11->display);
+        x11->display = NULL;
     }
 
     // TODO:
 
-    if (x11.empty_evt_pipe[0] || x11.empty_evt_pipe[1]) {
-        close(x11.empty_evt_pipe[0]);
-        close(x11.empty_evt_pipe[1]);
-    }
+    if (x11->epoll_fd != -1)
+        close(x11->epoll_fd);
+    if (x11->wake_wr != -1 && x11->wake_wr != x11->wake_rd)
+        close(x11->wake_wr);
+    if (x11->wake_rd != -1)
+        close(x11->wake_rd);
+    x11->epoll_fd = x11->wake_rd = x11->wake_wr = -1;
+
+    free(x11->watch.items);
+    x11->watch.items = NULL;
+    x11->watch.cnt = 0;
 }
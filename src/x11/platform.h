@@ -8,6 +8,7 @@
 #ifndef BGL_X11_PLATFORM_H
 #define BGL_X11_PLATFORM_H
 
+#include <stdatomic.h>
 
 #include <X11/Xatom.h>
 #include <X11/Xlib.h>
@@ -28,6 +29,14 @@ static const char *atom_names[] = {
 };
 
 
+typedef struct {
+    int fd;
+    bgl_fd_events events;
+    bgl_fd_fn callback;
+    void *user;
+} x11_fd_watch;
+
+
 struct bgl_platform {
     Display *display;
     int screen;
@@ -36,9 +45,26 @@ struct bgl_platform {
 
     short keycodes[256];
 
-    int empty_evt_pipe[2];
-# define eevt_rd empty_evt_pipe[0]
-# define eevt_wr empty_evt_pipe[1]
+    // X server milliseconds to timer ticks, see map_x11_time
+    struct {
+        int valid;
+        uint64_t last_ms;
+        int64_t offset;
+        uint64_t updated;
+    } time;
+
+    // empty events go through an eventfd, or a pipe where there is none
+    int wake_fds[2];
+# define wake_rd wake_fds[0]
+# define wake_wr wake_fds[1]
+    atomic_int wake_pending;
+
+    // the X connection, the wake fd and the user fds share one epoll set on Linux
+    int epoll_fd;
+    struct {
+        x11_fd_watch *items;
+        int cnt;
+    } watch;
 
     // Window manager atoms
     struct {
@@ -63,11 +89,21 @@ struct bgl_platform_window {
     int width;
     int height;
 
+    // server time of the last press per keycode, filters auto-repeat duplicates
+    Time key_times[256];
+
+    // latest ConfigureNotify size, applied once per event poll
+    int pending_width;
+    int pending_height;
+
     // renderers
     struct {
         XImage *ximg;
         GC gc;
         void *buffer;
+        size_t capacity;
+        Visual *visual;
+        int depth;
     } base;
 };
 
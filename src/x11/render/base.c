@@ -17,11 +17,6 @@
 
 
 #define SWAP(a, b) (((a) ^= (b)), ((b) ^= (a)), ((a) ^= (b)))
-#define VEC2ARGB(color) (                               \
-        (uint8_t)(((vec4s *)color)->a * 255) << 24      \
-        | (uint8_t)(((vec4s *)color)->r * 255) << 16    \
-        | (uint8_t)(((vec4s *)color)->g * 255) << 8     \
-        | (uint8_t)(((vec4s *)color)->b * 255))
 
 
 static void swap_buffers(bgl_instance bgl) {
@@ -32,9 +27,9 @@ static void swap_buffers(bgl_instance bgl) {
     memset(bgl->window->platform.base.buffer, 0, bgl->window->platform.width * bgl->window->platform.height * sizeof(uint32_t));
 }
 
-static void draw_pixel(bgl_instance bgl, const ivec3 v, const vec4 color) {
+static void draw_pixel(bgl_instance bgl, const ivec3 v, uint32_t color) {
 //    if (v->x >= 0 && v->x < bgl->window->platform.width && v->y >= 0 && v->y < bgl->window->platform.height)
-        XPutPixel(bgl->window->platform.base.ximg, v[0], v[1], VEC2ARGB(color));
+        XPutPixel(bgl->window->platform.base.ximg, v[0], v[1], color);
 }
 
 static void write_hline(bgl_instance bgl, int x1, int x2, int y, uint32_t color) {
@@ -143,22 +138,19 @@ static void write_line(bgl_instance bgl, const ivec3 a, const ivec3 b, uint32_t
     }
 }
 
-static void draw_line(bgl_instance bgl, const ivec3 a, const ivec3 b, const vec4 color) {
-    write_line(bgl, a, b, VEC2ARGB(color));
+static void draw_line(bgl_instance bgl, const ivec3 a, const ivec3 b, uint32_t color) {
+    write_line(bgl, a, b, color);
 }
 
-static void draw_triangle(bgl_instance bgl, const ivec3 a, const ivec3 b, const ivec3 c, const vec4 color) {
-    uint32_t argb = VEC2ARGB(color);
-
+static void draw_triangle(bgl_instance bgl, const ivec3 a, const ivec3 b, const ivec3 c, uint32_t argb) {
     write_line(bgl, a, b, argb);
     write_line(bgl, b, c, argb);
     write_line(bgl, c, a, argb);
 }
 
-static void draw_fill_triangle(bgl_instance bgl, const ivec3 a, const ivec3 b, const ivec3 c, const vec4 color) {
+static void draw_fill_triangle(bgl_instance bgl, const ivec3 a, const ivec3 b, const ivec3 c, uint32_t argb) {
 //    int width = bgl->window->platform.width - 1;
 //    int height = bgl->window->platform.height - 1;
-    uint32_t argb = VEC2ARGB(color);
     int ax = a[0], ay = a[1], bx = b[0], by = b[1], cx = c[0], cy = c[1];
 
     int dx_c, dx_b, dx_a, dy_c, dy_b, dy_a;
@@ -263,6 +255,51 @@ static void draw_fill_triangle(bgl_instance bgl, const ivec3 a, const ivec3 b, c
     }
 }
 
+/*!
+ * @brief Point the image at a framebuffer of the new size. Shrinking reuses the allocation,
+ * growing leaves headroom so the rest of a drag does not reallocate again.
+ */
+static int resize_framebuffer(bgl_instance bgl, int width, int height) {
+    typeof(bgl->window->platform.base) *render = &bgl->window->platform.base;
+    size_t fb_size = (size_t)width * (size_t)height * 4;    // ARGB
+    void *buffer = render->buffer;
+    size_t capacity = render->capacity;
+    XImage *ximg;
+
+    if (fb_size > capacity) {
+        capacity = (fb_size + fb_size / 4 + 31) & ~(size_t)31;
+        if (!(buffer = aligned_alloc(32, capacity))) {
+            fprintf(stderr, "Failed to resize render: framebuffer: %s\n", strerror(errno));
+            return false;
+        }
+    }
+
+    if (!(ximg = XCreateImage(bgl->platform.display,
+                              render->visual, render->depth, ZPixmap,
+                              0, buffer, width, height, 32, 0))) {
+        fprintf(stderr, "Failed to resize render: image\n");
+        if (buffer != render->buffer)
+            free(buffer);
+        return false;
+    }
+
+    if (render->ximg) {
+        render->ximg->data = NULL;
+        XDestroyImage(render->ximg);
+    }
+    if (buffer != render->buffer)
+        free(render->buffer);
+
+    render->ximg = ximg;
+    render->buffer = buffer;
+    render->capacity = capacity;
+
+    for (size_t i = 0; i < fb_size / 4; ++i)
+        ((uint32_t *)buffer)[i] = 0xFF000000;
+
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 int init_x11_base_render(bgl_instance bgl, Visual **visual, int *depth) {
@@ -287,6 +324,7 @@ int init_x11_base_render(bgl_instance bgl, Visual **visual, int *depth) {
 
     bgl->dev.destroy_render = destroy_x11_base_render;
     bgl->dev.swap_buffers = swap_buffers;
+    bgl->dev.resize_framebuffer = resize_framebuffer;
 
     bgl->dev.draw_pixel = draw_pixel;
     bgl->dev.draw_line = draw_line;
@@ -297,22 +335,15 @@ int init_x11_base_render(bgl_instance bgl, Visual **visual, int *depth) {
 }
 
 int create_x11_base_render(bgl_instance bgl, Visual *visual, int depth) {
-    size_t fb_size = bgl->window->platform.width * bgl->window->platform.height * 4;    // ARGB
     typeof(bgl->window->platform.base) *render = &bgl->window->platform.base;
 
     destroy_x11_base_render(bgl);
 
-    if (!(render->buffer = aligned_alloc(32, fb_size))) {
-        fprintf(stderr, "Failed to create render: framebuffer: %s\n", strerror(errno));
-        return false;
-    }
-    for (int i = 0; i < bgl->window->platform.width * bgl->window->platform.height; ++i)
-        ((uint32_t *)render->buffer)[i] = 0xFF000000;
+    render->visual = visual;
+    render->depth = depth;
 
-    render->ximg = XCreateImage(bgl->platform.display,
-                                visual, depth, ZPixmap,
-                                0, render->buffer,
-                                bgl->window->platform.width, bgl->window->platform.height, 32, 0);
+    if (!resize_framebuffer(bgl, bgl->window->platform.width, bgl->window->platform.height))
+        return false;
 
     render->gc = XCreateGC(bgl->platform.display, bgl->window->platform.window, 0, NULL);
 
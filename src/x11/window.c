@@ -8,6 +8,8 @@
 #define _GNU_SOURCE
 
 #include <errno.h>
+#include <limits.h>
+#include <math.h>
 #include <poll.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -15,6 +17,10 @@
 #include <string.h>
 #include <unistd.h>
 
+#if defined(__linux__)
+# include <sys/epoll.h>
+#endif
+
 #include "internal.h"
 #include "render/base.h"
 
@@ -22,6 +28,13 @@
 #define S2MS 1e3
 #define S2NS 1e9
 
+#define MAX_READY_FDS 32
+
+typedef struct {
+    int fd;
+    bgl_fd_events events;
+} ready_fd;
+
 static int create_x11_window(bgl_instance bgl, const bgl_window_cfg *w_cfg, Visual *visual, int depth) {
     bgl_platform_window *x11w = &bgl->window->platform;
 
@@ -115,67 +128,149 @@ static int create_x11_window(bgl_instance bgl, const bgl_window_cfg *w_cfg, Visu
 
     set_platform_window_title(bgl, w_cfg->title ? : "BGL-Window");
     // TODO: set pos and size
-    x11w->width = w_cfg->width;
-    x11w->height = w_cfg->height;
+    x11w->width = x11w->pending_width = w_cfg->width;
+    x11w->height = x11w->pending_height = w_cfg->height;
 
     return true;
 }
 
-static int poll_posix(bgl_instance bgl, struct pollfd* fds, nfds_t count, const double* timeout) {
-    while (1) {
-        if (timeout) {
-            double t = *timeout;
-            const uint64_t base = get_platform_timer_value(bgl);
-
-#if defined(__linux__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__CYGWIN__)
-            const time_t seconds = (time_t)t;
-            const long nanoseconds = (long)((t - (double)seconds) * S2NS);
-            const struct timespec ts = {seconds, nanoseconds};
-            const int result = ppoll(fds, count, &ts, NULL);
-#elif defined(__NetBSD__)
-            const time_t seconds = (time_t)t;
-            const long nanoseconds = (long)((t - (double)seconds) * S2NS);
-            const struct timespec ts = {seconds, nanoseconds};
-            const int result = pollts(fds, count, &ts, NULL);
+static x11_fd_watch *find_watch(bgl_instance bgl, int fd) {
+    for (int i = 0; i < bgl->platform.watch.cnt; ++i)
+        if (bgl->platform.watch.items[i].fd == fd)
+            return &bgl->platform.watch.items[i];
+    return NULL;
+}
+
+#if defined(__linux__)
+static uint32_t to_epoll_events(bgl_fd_events events) {
+    return (events & BGL_FD_READ ? EPOLLIN : 0) | (events & BGL_FD_WRITE ? EPOLLOUT : 0);
+}
+
+static bgl_fd_events from_epoll_events(uint32_t events) {
+    return (events & (EPOLLIN | EPOLLHUP) ? BGL_FD_READ : 0)
+           | (events & EPOLLOUT ? BGL_FD_WRITE : 0)
+           | (events & EPOLLERR ? BGL_FD_ERROR : 0);
+}
 #else
-            const int milliseconds = (int)(t * S2MS);
-            const int result = poll(fds, count, milliseconds);
+static short to_poll_events(bgl_fd_events events) {
+    return (events & BGL_FD_READ ? POLLIN : 0) | (events & BGL_FD_WRITE ? POLLOUT : 0);
+}
+
+static bgl_fd_events from_poll_events(short events) {
+    return (events & (POLLIN | POLLHUP) ? BGL_FD_READ : 0)
+           | (events & POLLOUT ? BGL_FD_WRITE : 0)
+           | (events & (POLLERR | POLLNVAL) ? BGL_FD_ERROR : 0);
+}
 #endif
-            const int error = errno; // clock_gettime may overwrite our error
 
-            t -= (double)(get_platform_timer_value(bgl) - base) /
-                 (double)get_platform_timer_freq(bgl);
+/*!
+ * @brief Single wait on the X connection, the wake fd and the watched fds, NULL timeout waits forever.
+ * @return Number of ready fds, 0 on timeout, -1 on error. Ready watched fds go to `ready` when given.
+ */
+static int wait_fds(bgl_instance bgl, const double *timeout, ready_fd *ready, int *ready_cnt) {
+    const int x11_fd = ConnectionNumber(bgl->platform.display);
+    int result, cnt = 0;
 
-            if (result > 0)
-                return true;
-            else if (result == -1 && error != EINTR && error != EAGAIN || t <= 0.0)
-                return false;
-        } else {
-            const int result = poll(fds, count, -1);
-            if (result > 0)
-                return true;
-            else if (result == -1 && errno != EINTR && errno != EAGAIN)
-                return false;
-        }
+#if defined(__linux__)
+    struct epoll_event evts[MAX_READY_FDS];
+    int ms = -1;
+
+    // round up, a sub-millisecond remainder would otherwise spin
+    if (timeout)
+        ms = *timeout * S2MS >= INT_MAX ? INT_MAX : (int)ceil(*timeout * S2MS);
+
+    result = epoll_wait(bgl->platform.epoll_fd, evts, MAX_READY_FDS, ms);
+
+    for (int i = 0; ready && i < result; ++i)
+        if (evts[i].data.fd != x11_fd && evts[i].data.fd != bgl->platform.wake_rd)
+            ready[cnt++] = (ready_fd){evts[i].data.fd, from_epoll_events(evts[i].events)};
+#else
+    const int count = 2 + bgl->platform.watch.cnt;
+    struct pollfd fds[count];
+
+    fds[0] = (struct pollfd){bgl->platform.wake_rd, POLLIN};
+    fds[1] = (struct pollfd){x11_fd, POLLIN};
+    for (int i = 0; i < bgl->platform.watch.cnt; ++i)
+        fds[2 + i] = (struct pollfd){bgl->platform.watch.items[i].fd,
+                                     to_poll_events(bgl->platform.watch.items[i].events)};
+
+    if (timeout) {
+        const double t = *timeout;
+# if defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__CYGWIN__)
+        const time_t seconds = (time_t)t;
+        const long nanoseconds = (long)((t - (double)seconds) * S2NS);
+        const struct timespec ts = {seconds, nanoseconds};
+        result = ppoll(fds, count, &ts, NULL);
+# elif defined(__NetBSD__)
+        const time_t seconds = (time_t)t;
+        const long nanoseconds = (long)((t - (double)seconds) * S2NS);
+        const struct timespec ts = {seconds, nanoseconds};
+        result = pollts(fds, count, &ts, NULL);
+# else
+        result = poll(fds, count, t * S2MS >= INT_MAX ? INT_MAX : (int)ceil(t * S2MS));
+# endif
+    } else {
+        result = poll(fds, count, -1);
     }
+
+    for (int i = 2; ready && result > 0 && i < count && cnt < MAX_READY_FDS; ++i)
+        if (fds[i].revents)
+            ready[cnt++] = (ready_fd){fds[i].fd, from_poll_events(fds[i].revents)};
+#endif
+
+    if (ready_cnt)
+        *ready_cnt = cnt;
+
+    return result;
 }
 
 static int wait_any_event(bgl_instance bgl, double *t) {
-    struct pollfd fds[2] = {
-            {bgl->platform.eevt_rd, POLLIN},
-            {ConnectionNumber(bgl->platform.display), POLLIN},
-    };
-
     while (!XPending(bgl->platform.display)) {
-        if (!poll_posix(bgl, fds, 2, t))
-            return false;
+        const uint64_t base = get_platform_timer_value(bgl);
+        const int result = wait_fds(bgl, t, NULL, NULL);
+        const int error = errno; // clock_gettime may overwrite our error
 
-        if (fds[0].revents & POLLIN || fds[1].revents & POLLIN)
+        if (result > 0)
             return true;
+        else if (result == -1 && error != EINTR && error != EAGAIN)
+            return false;
+
+        if (t) {
+            *t -= (double)(get_platform_timer_value(bgl) - base) /
+                  (double)get_platform_timer_freq(bgl);
+            if (*t <= 0.0)
+                return false;
+        }
     }
     return true;
 }
 
+/*!
+ * @brief Map X server milliseconds onto the timer. Events cannot arrive before they happen,
+ * so the smallest (arrival - server time) gap seen is the best offset. It creeps up by 1 ms/s
+ * so drift between the two clocks is followed as well.
+ */
+static uint64_t map_x11_time(bgl_instance bgl, Time t) {
+    typeof(bgl->platform.time) *xt = &bgl->platform.time;
+    uint64_t now = get_platform_timer_value(bgl), freq = get_platform_timer_freq(bgl);
+
+    // server time is 32 bit and wraps every ~49 days
+    uint64_t ms = xt->valid ? xt->last_ms + (int32_t)((uint32_t)t - (uint32_t)xt->last_ms) : (uint32_t)t;
+    uint64_t ticks = ms / 1000 * freq + ms % 1000 * freq / 1000;
+    int64_t offset = (int64_t)(now - ticks);
+
+    if (xt->valid)
+        xt->offset += (int64_t)((now - xt->updated) / 1000);
+    if (!xt->valid || offset < xt->offset)
+        xt->offset = offset;
+    xt->valid = true;
+    xt->last_ms = ms;
+    xt->updated = now;
+
+    uint64_t mapped = ticks + (uint64_t)xt->offset;
+    return mapped < now ? mapped : now;
+}
+
 static int translate_key(bgl_instance bgl, unsigned keycode) {
     if (keycode > 255)
         return BGL_KEY_UNKNOWN;
@@ -217,11 +312,11 @@ static void process_event(bgl_instance bgl, XEvent *evt) {
         int key = translate_key(bgl, keycode);
         int mods = translate_state(evt->xkey.state);
 
-        Time diff = evt->xkey.time - bgl->window->keys[keycode].time;
+        Time diff = evt->xkey.time - bgl->window->platform.key_times[keycode];
         if (diff == evt->xkey.time || (diff > 0 && diff < ((Time)1 << 31))) {
             if (keycode)
-                input_key(bgl, key, keycode, BGL_PRESS, mods);
-            bgl->window->keys[keycode].time = evt->xkey.time;
+                input_key(bgl, key, keycode, BGL_PRESS, mods, map_x11_time(bgl, evt->xkey.time));
+            bgl->window->platform.key_times[keycode] = evt->xkey.time;
         }
 
         return;
@@ -245,7 +340,7 @@ static void process_event(bgl_instance bgl, XEvent *evt) {
             }
         }
 
-        input_key(bgl, key, keycode, BGL_RELEASE, mods);
+        input_key(bgl, key, keycode, BGL_RELEASE, mods, map_x11_time(bgl, evt->xkey.time));
 
         return;
     }
@@ -284,13 +379,9 @@ static void process_event(bgl_instance bgl, XEvent *evt) {
     case Expose:    // window content needs updating/refreshing
         return;
     case ConfigureNotify:
-        if (evt->xconfigure.width != bgl->window->platform.width
-                || evt->xconfigure.height != bgl->window->platform.height) {
-            bgl->window->platform.width = evt->xconfigure.width;
-            bgl->window->platform.height = evt->xconfigure.height;
-
-//            _bgl_set_base_framebuffer_size(w, w->platform.width, w->platform.height);
-        }
+        // a drag sends bursts of these, only the last size of a poll is applied
+        bgl->window->platform.pending_width = evt->xconfigure.width;
+        bgl->window->platform.pending_height = evt->xconfigure.height;
         return;
     case DestroyNotify:
     default:
@@ -388,11 +479,72 @@ int is_visible_platform_window(bgl_instance bgl) {
     return attr.map_state == IsViewable;
 }
 
+void get_platform_window_size(bgl_instance bgl, int *width, int *height) {
+    if (width)
+        *width = bgl->window->platform.pending_width;
+    if (height)
+        *height = bgl->window->platform.pending_height;
+}
+
+void get_platform_framebuffer_size(bgl_instance bgl, int *width, int *height) {
+    if (width)
+        *width = bgl->window->platform.width;
+    if (height)
+        *height = bgl->window->platform.height;
+}
+
 
 /// window events
 
+static void drain_empty_events(bgl_instance bgl) {
+    char buf[64];
+
+    // the fd is non-blocking, a single read resets an eventfd
+    while (read(bgl->platform.wake_rd, buf, sizeof(buf)) > 0);
+
+    // senders skipped the write while the flag was up, whatever they published is handled after this
+    atomic_store(&bgl->platform.wake_pending, false);
+}
+
+static void dispatch_ready_fds(bgl_instance bgl, const ready_fd *ready, int cnt) {
+    for (int i = 0; i < cnt; ++i) {
+        // an earlier callback may have unwatched it
+        x11_fd_watch *w = find_watch(bgl, ready[i].fd);
+        if (!w)
+            continue;
+
+        bgl_fd_events events = ready[i].events & (w->events | BGL_FD_ERROR);
+        if (events)
+            w->callback(bgl, w->fd, events, w->user);
+    }
+}
+
+static void apply_pending_size(bgl_instance bgl) {
+    bgl_platform_window *x11w = &bgl->window->platform;
+    int old_width = x11w->width, old_height = x11w->height;
+    int width = x11w->pending_width, height = x11w->pending_height;
+
+    if ((width == old_width && height == old_height) || width <= 0 || height <= 0)
+        return;
+
+    // on failure the old framebuffer stays and the next poll retries
+    if (bgl->dev.resize_framebuffer && !bgl->dev.resize_framebuffer(bgl, width, height))
+        return;
+
+    x11w->width = width;
+    x11w->height = height;
+    input_window_resize(bgl, old_width, old_height, width, height);
+}
+
 void poll_platform_window_events(bgl_instance bgl) {
-    // TODO: drain empty events?
+    ready_fd ready[MAX_READY_FDS];
+    const double now = 0;
+    int ready_cnt = 0;
+
+    if (bgl->platform.watch.cnt)
+        wait_fds(bgl, &now, ready, &ready_cnt);
+
+    drain_empty_events(bgl);
 
     XPending(bgl->platform.display);
 
@@ -402,7 +554,12 @@ void poll_platform_window_events(bgl_instance bgl) {
         process_event(bgl, &evt);
     }
 
+    if (bgl->window)
+        apply_pending_size(bgl);
+
     XFlush(bgl->platform.display);
+
+    dispatch_ready_fds(bgl, ready, ready_cnt);
 }
 
 void wait_platform_window_events(bgl_instance bgl) {
@@ -416,9 +573,68 @@ void wait_platform_window_events_timeout(bgl_instance bgl, double t) {
 }
 
 void send_platform_window_empty_event(bgl_instance bgl) {
-    char d = 0;
+    // wakeups coalesce until the next drain
+    if (atomic_exchange(&bgl->platform.wake_pending, true))
+        return;
+
+    // an eventfd takes exactly 8 bytes, a pipe does not mind
+    const uint64_t one = 1;
     ssize_t x;
     do {
-        x = write(bgl->platform.eevt_wr, &d, 1);
-    } while (x != 1 && (x == -1 && errno == EINTR));
+        x = write(bgl->platform.wake_wr, &one, sizeof(one));
+    } while (x == -1 && errno == EINTR);
+}
+
+int watch_platform_fd(bgl_instance bgl, int fd, bgl_fd_events events, bgl_fd_fn callback, void *user) {
+    x11_fd_watch *w = find_watch(bgl, fd);
+    const int added = !w;
+
+    if (added) {
+        x11_fd_watch *items = bgl_realloc_array(bgl->platform.watch.items, bgl->platform.watch.cnt + 1, sizeof(*items));
+        if (!items) {
+            fprintf(stderr, "X11: Failed to watch fd %d: %s\n", fd, strerror(errno));
+            return false;
+        }
+        bgl->platform.watch.items = items;
+        w = &items[bgl->platform.watch.cnt];
+    }
+
+#if defined(__linux__)
+    struct epoll_event evt = {.events = to_epoll_events(events), .data.fd = fd};
+    if (epoll_ctl(bgl->platform.epoll_fd, added ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &evt)) {
+        fprintf(stderr, "X11: Failed to watch fd %d: %s\n", fd, strerror(errno));
+        return false;
+    }
+#endif
+
+    *w = (x11_fd_watch){fd, events, callback, user};
+    bgl->platform.watch.cnt += added;
+
+    return true;
+}
+
+int unwatch_platform_fd(bgl_instance bgl, int fd) {
+    x11_fd_watch *w = find_watch(bgl, fd);
+
+    if (!w) {
+        fprintf(stderr, "X11: Fd %d is not watched\n", fd);
+        return false;
+    }
+
+#if defined(__linux__)
+    // the fd may be closed already, which removed it from the set
+    epoll_ctl(bgl->platform.epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+#endif
+
+    *w = bgl->platform.watch.items[--bgl->platform.watch.cnt];
+
+    return true;
+}
+
+int get_platform_event_fd(bgl_instance bgl) {
+#if defined(__linux__)
+    return bgl->platform.epoll_fd;
+#else
+    return -1;
+#endif
 }